@@ -0,0 +1,48 @@
+// the buffers of LightClusters, #include "clusters.glsl"
+
+struct ClusterLight {
+    vec4 positionRadius;    // world space
+    vec4 color;
+};
+
+layout (std140) uniform Clusters{
+    mat4 clusterView;
+    mat4 clusterProjection;
+    mat4 clusterInverseProjection;
+    vec4 clusterViewport;   // x, y, width, height
+    vec4 clusterDepth;      // near, far, log scale, log bias
+    uvec4 clusterGrid;      // tiles x, tiles y, slices, 1 if perspective
+};
+
+layout (std430, binding = 0) buffer ClusterLights{
+    uvec4 clusterLightAmount;   // x
+    ClusterLight clusterLights[];
+};
+
+layout (std430, binding = 1) buffer ClusterCounts{
+    uint clusterCounts[];
+};
+
+#define MAX_LIGHTS_PER_CLUSTER 64
+layout (std430, binding = 2) buffer ClusterIndices{
+    uint clusterIndices[];
+};
+
+// the depth slice of a view distance
+uint clusterSlice(float distance)
+{
+    float slice;
+    if (clusterGrid.w == 1u)
+        slice = log(max(distance, clusterDepth.x)) * clusterDepth.z + clusterDepth.w;
+    else
+        slice = (distance - clusterDepth.x) / (clusterDepth.y - clusterDepth.x) * float(clusterGrid.z);
+    return uint(clamp(slice, 0.0, float(clusterGrid.z) - 1.0));
+}
+
+// the view distance where a slice starts
+float clusterSliceStart(uint slice)
+{
+    if (clusterGrid.w == 1u)
+        return clusterDepth.x * pow(clusterDepth.y / clusterDepth.x, float(slice) / float(clusterGrid.z));
+    return mix(clusterDepth.x, clusterDepth.y, float(slice) / float(clusterGrid.z));
+}
\ No newline at end of file
@@ -0,0 +1,17 @@
+#version 430 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+
+layout (std140) uniform Matrices{
+    mat4 view;
+    mat4 projection;
+};
+
+// the depth pre-pass, the lit pass computes the same position and tests the depth for equal
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
\ No newline at end of file
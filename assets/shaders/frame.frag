@@ -5,20 +5,29 @@ out vec4 FragColor;
 
 uniform float frame;
 uniform float shineTime;
-uniform bool useCrosshair = false;
-uniform bool bulletTime = false;
-uniform bool useSpiral = false;
-uniform bool useImpact = false;
-uniform bool useSpeed = false;
+// the effects are USE_CROSSHAIR, BULLET_TIME, USE_SPIRAL, USE_IMPACT and USE_SPEED, set by Shader::variant()
 
 uniform float screenAspectRatio=1.0;
 uniform sampler2D screenTexture;
+// the part of screenTexture the scene is drawn in, by dynamic resolution
+uniform vec2 renderScale = vec2(1.0);
 uniform sampler2D crosshairTexture;
-uniform sampler2D whiteLineTexture;
+uniform sampler2D whiteLineTexture;	// the outline mask of the scene, drawn with it
 
 vec4 grayScale(vec4 color);
 vec4 reduceSaturation(vec4 color, float strength);
 
+// the coordinates in the drawn part, the texels out of it are never filtered in
+vec2 sceneCoords(vec2 coords) {
+    vec2 halfTexel = 0.5 / vec2(textureSize(screenTexture, 0));
+    return clamp(coords * renderScale, halfTexel, renderScale - halfTexel);
+}
+
+// the scene upscaled to the window
+vec4 scene(vec2 coords) {
+    return texture(screenTexture, sceneCoords(coords));
+}
+
 float hash(float n) {
     return -1+fract(sin(n*678.9))*2;
 }
@@ -31,34 +40,36 @@ void main()
 
     vec4 color;
 
-    color = texture(screenTexture, TexCoords);
+    color = scene(TexCoords);
 //    float red = texture(screenTexture, TexCoords).r;
 //    color=vec4(red,red*10.0f,red/10.0f,1.0);
-    if(useCrosshair){
-        vec2 scaledCoords = vec2((TexCoords.x-0.5)* screenAspectRatio*0.5+0.5, TexCoords.y );
-        vec4 temp_color = texture(crosshairTexture, scaledCoords);
-        color = mix(color,temp_color,temp_color.w);
-    }
+#ifdef USE_CROSSHAIR
+    vec2 scaledCoords = vec2((TexCoords.x-0.5)* screenAspectRatio*0.5+0.5, TexCoords.y );
+    vec4 temp_color = texture(crosshairTexture, scaledCoords);
+    color = mix(color,temp_color,temp_color.w);
+#endif
 
     // bullet time
-    if (bulletTime){
-
+#ifdef BULLET_TIME
+    {
         vec2 outward = TexCoords-vec2(0.5,0.5);
-        color = mix(color,texture(screenTexture, TexCoords-outward*0.04),0.05);
-        color = mix(color,texture(screenTexture, TexCoords-outward*0.03),0.1);
-        color = mix(color,texture(screenTexture, TexCoords-outward*0.02),0.15);
-        color = mix(color,texture(screenTexture, TexCoords-outward*0.01),0.2);
+        color = mix(color,scene(TexCoords-outward*0.04),0.05);
+        color = mix(color,scene(TexCoords-outward*0.03),0.1);
+        color = mix(color,scene(TexCoords-outward*0.02),0.15);
+        color = mix(color,scene(TexCoords-outward*0.01),0.2);
 
         color =reduceSaturation(color,0.8);
         float r = abs((TexCoords.x-0.5)*(TexCoords.x-0.5)*4+(TexCoords.y-0.5)*(TexCoords.y-0.5)*4);
         color = mix(color,black,(r-0.5)*0.5);
         color = mix(color,black,0.1);
-        if(texture(whiteLineTexture, vec2(TexCoords.x+0.0017f,TexCoords.y))!=texture(whiteLineTexture, vec2(TexCoords.x,TexCoords.y+0.0017f)))
+        if(texture(whiteLineTexture, sceneCoords(vec2(TexCoords.x+0.0017f,TexCoords.y)))!=texture(whiteLineTexture, sceneCoords(vec2(TexCoords.x,TexCoords.y+0.0017f))))
             color = white;
     }
+#endif
 
     // green border
-    if(useSpiral){
+#ifdef USE_SPIRAL
+    {
         texture(whiteLineTexture, vec2(TexCoords.x+0.0017f,TexCoords.y));
         float r = abs((TexCoords.x-0.5)*(TexCoords.x-0.5)*4+(TexCoords.y-0.5)*(TexCoords.y-0.5)*4);
         color = mix(color,lightGreen,(r-0.5)*0.5*abs(sin(shineTime*6.28*0.015)));
@@ -69,16 +80,18 @@ void main()
 //            color = mix(color,white,(max((length(outward)-0.45)*5,0)));
 //        }
     }
-
-    if(useImpact){
-        color =reduceSaturation(color,1);
-        if(color.r>0.5)
-            color = white;
-        else
-            color = black;
-    }
-
-    if(useSpeed){
+#endif
+
+#ifdef USE_IMPACT
+    color =reduceSaturation(color,1);
+    if(color.r>0.5)
+        color = white;
+    else
+        color = black;
+#endif
+
+#ifdef USE_SPEED
+    {
         vec2 outward = TexCoords-vec2(0.5,0.5);
         float angle = atan(outward.y, outward.x)+hash(frame)*6.28; 
 
@@ -89,6 +102,7 @@ void main()
             color = mix(color,white,(max((length(outward)-0.45)*5,0)));
         }
     }
+#endif
     FragColor = color;
 }
 
@@ -10,8 +10,6 @@ layout (std140) uniform Matrices{
     mat4 projection;
 };
 
-uniform bool useImage;
-
 out V_OUT
 {
    vec3 position;
@@ -25,9 +23,9 @@ void main()
     gl_Position = projection * view * model * vec4(position, 1);
     v_out.position = (model * vec4(position, 1)).xyz;
     v_out.normal = mat3(normalMatrix) * normal;
-    vec2 texCoord = vec2(0,0);
-    if(useImage){
-        texCoord = texCoordIn;
-    }
-    v_out.texCoord = texCoord;
+#ifdef USE_IMAGE
+    v_out.texCoord = texCoordIn;
+#else
+    v_out.texCoord = vec2(0,0);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,193 @@
+// the lights of the scene, #include "lighting.glsl" in a lit fragment shader
+// the shader sets the uniform eyePosition and calls CalcLights() with its own material
+// the shader needs the uniform block Clusters bound to LightClusters::CLUSTER_BLOCK_BINDING,
+// the block Shadows bound to ShadowMap::SHADOW_BLOCK_BINDING and shadowMap set to ShadowMap::SHADOW_TEXTURE_UNIT
+
+#include "clusters.glsl"
+#include "shadows.glsl"
+
+struct Material {
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;    
+    float shininess;
+}; 
+
+struct DirLight {
+    vec3 direction;
+  
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};  
+
+struct PointLight {    
+    vec3 position;
+    
+    float constant;
+    float linear;
+    float quadratic;  
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff; //this will be set by cos(theta)
+    float outerCutOff; //this will be set by cos(theta)
+
+    float constant;
+    float linear;
+    float quadratic;  
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+uniform vec3 eyePosition;
+uniform DirLight dirLight;
+#define NR_POINT_LIGHTS 4  
+uniform PointLight pointLights[NR_POINT_LIGHTS];
+#define NR_SPOT_LIGHTS 4  
+uniform SpotLight spotLights[NR_SPOT_LIGHTS];
+// the lights not black, set by Shader::variant()
+#ifndef ACTIVE_POINT_LIGHTS
+#define ACTIVE_POINT_LIGHTS NR_POINT_LIGHTS
+#endif
+#ifndef ACTIVE_SPOT_LIGHTS
+#define ACTIVE_SPOT_LIGHTS NR_SPOT_LIGHTS
+#endif
+// the main light, the only one casting shadows
+#define SHADOW_POINT_LIGHT 0
+uniform sampler2DArrayShadow shadowMap;
+
+// 0 in the shadow of the main light, 1 if lit
+float CalcShadow(vec3 normal, vec3 position)
+{
+    if (shadowSplits.w == 0.0)
+        return 1.0;
+    float distance = -(clusterView * vec4(position, 1.0)).z;
+    int cascade = 0;
+    while (cascade < SHADOW_CASCADES - 1 && distance > shadowSplits[cascade])
+        cascade++;
+    if (distance > shadowSplits[SHADOW_CASCADES - 1])
+        return 1.0;
+    // a texel along the normal, so a surface doesn't shadow itself
+    vec4 lightPos = shadowMatrices[cascade] * vec4(position + normal * shadowTexelSizes[cascade], 1.0);
+    vec3 coord = lightPos.xyz / lightPos.w * 0.5 + 0.5;
+    // the comparison of the 4 nearest texels is filtered by the texture
+    return texture(shadowMap, vec4(coord.xy, float(cascade), coord.z));
+}
+
+vec3 CalcDirLight(DirLight light, Material material, vec3 normal, vec3 eyeDir)
+{
+    vec3 lightDir = normalize(-light.direction);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 halfwayDir = normalize(lightDir + eyeDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
+    // combine results
+    vec3 ambient  = light.ambient * material.ambient;
+    vec3 diffuse  = light.diffuse * diff * material.diffuse;
+    vec3 specular = light.specular * spec * material.specular;
+    return (ambient + diffuse + specular);
+}
+
+vec3 CalcPointLight(PointLight light, Material material, vec3 normal, vec3 position, vec3 eyeDir, float shadow)
+{
+    vec3 lightDir = normalize(light.position - position);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 halfwayDir = normalize(lightDir + eyeDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
+    // attenuation
+    float distance    = length(light.position - position);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
+    // combine results
+    vec3 ambient  = light.ambient * material.ambient;
+    vec3 diffuse  = light.diffuse * diff * material.diffuse;
+    vec3 specular = light.specular * spec * material.specular;
+    ambient  *= attenuation;
+    diffuse  *= attenuation;
+    specular *= attenuation;
+    return (ambient + shadow * (diffuse + specular));
+}
+
+vec3 CalcSpotLight(SpotLight light, Material material, vec3 normal, vec3 position, vec3 eyeDir){
+    vec3 lightDir = normalize(light.position - position);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 halfwayDir = normalize(lightDir + eyeDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
+    // attenuation
+    float distance    = length(light.position - position);
+    float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
+    // combine results
+    vec3 ambient  = light.ambient * material.ambient;
+    vec3 diffuse  = light.diffuse * diff * material.diffuse;
+    vec3 specular = light.specular * spec * material.specular;
+    // spotlight (soft edges)
+    float theta = dot(lightDir, normalize(-light.direction)); 
+    float epsilon = (light.cutOff - light.outerCutOff);
+    float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
+    diffuse  *= intensity;
+    specular *= intensity;
+
+    ambient  *= attenuation;
+    diffuse  *= attenuation;
+    specular *= attenuation;
+    return (ambient + diffuse + specular);
+}
+
+// a light of the clusters, it fades to nothing at its radius
+vec3 CalcClusterLight(ClusterLight light, Material material, vec3 normal, vec3 position, vec3 eyeDir)
+{
+    vec3 toLight = light.positionRadius.xyz - position;
+    float distance = length(toLight);
+    float falloff = clamp(1.0 - distance / light.positionRadius.w, 0.0, 1.0);
+    falloff *= falloff;
+    vec3 lightDir = toLight / max(distance, 0.0001);
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    vec3 halfwayDir = normalize(lightDir + eyeDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), material.shininess);
+    return light.color.rgb * falloff * (diff * material.diffuse + spec * material.specular);
+}
+
+// the directional light, the active point and spot lights and the lights of the cluster
+vec3 CalcLights(Material material, vec3 normal, vec3 position, vec3 eyeDir)
+{
+    // phase 1: Directional lighting
+    vec3 result = CalcDirLight(dirLight, material, normal, eyeDir);
+    // phase 2: Point lights, the main light is shadowed
+    for(int i = 0; i < ACTIVE_POINT_LIGHTS; i++){
+        float shadow = i == SHADOW_POINT_LIGHT ? CalcShadow(normal, position) : 1.0;
+        result += CalcPointLight(pointLights[i], material, normal, position, eyeDir, shadow);    
+    }
+        
+    // phase 3: Spot light
+    for(int i = 0; i < ACTIVE_SPOT_LIGHTS; i++){
+        result += CalcSpotLight(spotLights[i], material, normal, position, eyeDir);
+    }
+
+    // phase 4: the lights of the cluster of this fragment, e.g. the explosions
+    if (clusterLightAmount.x > 0u) {
+        vec2 tile = (gl_FragCoord.xy - clusterViewport.xy) / clusterViewport.zw * vec2(clusterGrid.xy);
+        uvec2 tileId = uvec2(clamp(tile, vec2(0.0), vec2(clusterGrid.xy) - 1.0));
+        float distance = -(clusterView * vec4(position, 1.0)).z;
+        uint cluster = (clusterSlice(distance) * clusterGrid.y + tileId.y) * clusterGrid.x + tileId.x;
+        uint count = clusterCounts[cluster];
+        for (uint i = 0u; i < count; i++) {
+            result += CalcClusterLight(clusterLights[clusterIndices[cluster * MAX_LIGHTS_PER_CLUSTER + i]], material, normal, position, eyeDir);
+        }
+    }
+    return result;
+}
\ No newline at end of file
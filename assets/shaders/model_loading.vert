@@ -14,6 +14,9 @@ layout (std140) uniform Matrices{
     mat4 projection;
 };
 
+// the same depth as depthOnly.vert for the pre-pass
+invariant gl_Position;
+
 void main()
 {
     TexCoords = aTexCoords;   
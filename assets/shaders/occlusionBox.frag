@@ -0,0 +1,8 @@
+#version 430 core
+out vec4 f_color;
+
+// color and depth write are off, only the samples passed are counted
+void main()
+{
+    f_color = vec4(1.0);
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#version 430 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+
+layout (std140) uniform Matrices{
+    mat4 view;
+    mat4 projection;
+};
+
+void main()
+{
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
\ No newline at end of file
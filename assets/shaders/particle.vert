@@ -8,10 +8,13 @@ layout (std140) uniform Matrices{
     mat4 projection;
 };
 
+// the point size is in pixels of the scene, it is drawn smaller by dynamic resolution
+uniform float pointScale = 1.0;
+
 out vec3 fragColor;
 
 void main() {
-    const float scale = 1000.0f;
+    float scale = 1000.0f * pointScale;
 
     gl_Position = projection * view * vec4(instancePos, 1.0); // ϥβɤlm@̲צm
     gl_PointSize = instanceSize * scale / gl_Position.z;          // ]wɤljp
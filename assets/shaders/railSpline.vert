@@ -0,0 +1,16 @@
+#version 430 core
+// a patch is the 4 control points of a track segment
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 orient;
+
+out vec3 tcPosition;
+out vec3 tcOrient;
+out float tcSide;
+
+void main()
+{
+    tcPosition = position;
+    tcOrient = orient;
+    // instance 0 is the left rail, 1 is the right rail
+    tcSide = gl_InstanceID == 0 ? -1.0 : 1.0;
+}
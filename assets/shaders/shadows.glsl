@@ -0,0 +1,9 @@
+// the block of ShadowMap, #include "shadows.glsl"
+
+#define SHADOW_CASCADES 3
+
+layout (std140) uniform Shadows{
+    mat4 shadowMatrices[SHADOW_CASCADES];   // world to the clip space of the light
+    vec4 shadowSplits;      // the far view distance of every cascade, w = 1 if enabled
+    vec4 shadowTexelSizes;  // world size of a texel of every cascade
+};
\ No newline at end of file
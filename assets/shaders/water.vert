@@ -13,6 +13,9 @@ layout (std140) uniform Matrices{
     mat4 projection;
 };
 
+// the same depth as the water of the pre-pass
+invariant gl_Position;
+
 out V_OUT {
     vec3 position;
     vec2 texCoords;
@@ -0,0 +1,12 @@
+#include "Benchmark.h"
+
+int main(int argc, char** argv)
+{
+	Benchmark bench(argc, argv);
+	addMathBenchmarks(bench);
+	addTrackBenchmarks(bench);
+	addParticleBenchmarks(bench);
+	addCollisionBenchmarks(bench);
+	addModelBenchmarks(bench);
+	return bench.finish();
+}
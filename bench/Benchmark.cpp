@@ -0,0 +1,142 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+static volatile float floatSink;
+static const void* volatile pointerSink;
+
+static void printUsage() {
+	printf("usage: RollerBench [options]\n"
+		"  --filter <text>       only run the benchmarks whose name contain the text\n"
+		"  --time <seconds>      length of a repetition, default 0.1\n"
+		"  --repetitions <n>     repetitions of a benchmark, the median is reported, default 5\n"
+		"  --csv <file>          write the results\n"
+		"  --compare <file>      compare with the results of another run\n"
+		"  --threshold <ratio>   a slow down over it is a regression, default 0.1\n");
+}
+
+Benchmark::Benchmark(int argc, char** argv) {
+	for (int i = 1; i < argc; i++) {
+		const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+		if (strcmp(argv[i], "--help") == 0) {
+			isValid = false;
+		}
+		else if (value == nullptr) {
+			printf("missing the value of %s\n", argv[i]);
+			isValid = false;
+		}
+		else {
+			if (strcmp(argv[i], "--filter") == 0)
+				filter = value;
+			else if (strcmp(argv[i], "--time") == 0)
+				minTime = atof(value);
+			else if (strcmp(argv[i], "--repetitions") == 0)
+				repetitions = std::max(1, atoi(value));
+			else if (strcmp(argv[i], "--csv") == 0)
+				csvPath = value;
+			else if (strcmp(argv[i], "--compare") == 0)
+				comparePath = value;
+			else if (strcmp(argv[i], "--threshold") == 0)
+				threshold = atof(value);
+			else {
+				printf("unknown option %s\n", argv[i]);
+				isValid = false;
+			}
+			i++;
+		}
+	}
+	if (!isValid)
+		printUsage();
+	else
+		printf("%-44s %12s %14s %16s\n", "benchmark", "iterations", "ns/op", "items/s");
+}
+
+bool Benchmark::isEnabled(const std::string& name) const {
+	return isValid && (filter.empty() || name.find(filter) != std::string::npos);
+}
+
+void Benchmark::record(const std::string& name, double items, long long iterations, std::vector<double>& seconds) {
+	std::sort(seconds.begin(), seconds.end());
+	double median = seconds[seconds.size() / 2];
+	Result result;
+	result.name = name;
+	result.iterations = iterations;
+	result.nsPerOp = median * 1e9 / iterations;
+	result.itemsPerSecond = median > 0 ? items * iterations / median : 0;
+	results.push_back(result);
+	printf("%-44s %12lld %14.1f %16.4g\n", name.c_str(), iterations, result.nsPerOp, result.itemsPerSecond);
+	fflush(stdout);
+}
+
+int Benchmark::finish() {
+	if (!isValid)
+		return 2;
+	if (!csvPath.empty() && !writeCSV())
+		return 2;
+	if (!comparePath.empty())
+		return compare() ? 0 : 1;
+	return 0;
+}
+
+bool Benchmark::writeCSV() const {
+	FILE* file = fopen(csvPath.c_str(), "w");
+	if (file == nullptr) {
+		printf("can't write %s\n", csvPath.c_str());
+		return false;
+	}
+	fprintf(file, "name,iterations,ns_per_op,items_per_second\n");
+	for (const Result& r : results)
+		fprintf(file, "%s,%lld,%.3f,%.6g\n", r.name.c_str(), r.iterations, r.nsPerOp, r.itemsPerSecond);
+	fclose(file);
+	return true;
+}
+
+// false if any benchmark is slower than the threshold
+bool Benchmark::compare() const {
+	FILE* file = fopen(comparePath.c_str(), "r");
+	if (file == nullptr) {
+		printf("can't read %s\n", comparePath.c_str());
+		return false;
+	}
+	std::map<std::string, double> baseline;
+	char line[512];
+	fgets(line, sizeof(line), file);	// header
+	while (fgets(line, sizeof(line), file)) {
+		char* comma = strchr(line, ',');
+		if (comma == nullptr)
+			continue;
+		long long iterations;
+		double nsPerOp;
+		if (sscanf(comma + 1, "%lld,%lf", &iterations, &nsPerOp) == 2)
+			baseline[std::string(line, comma)] = nsPerOp;
+	}
+	fclose(file);
+
+	printf("\ncompared with %s\n", comparePath.c_str());
+	printf("%-44s %14s %14s %9s\n", "benchmark", "before ns/op", "now ns/op", "change");
+	int regressions = 0;
+	for (const Result& r : results) {
+		auto base = baseline.find(r.name);
+		if (base == baseline.end()) {
+			printf("%-44s %14s %14.1f %9s\n", r.name.c_str(), "-", r.nsPerOp, "new");
+			continue;
+		}
+		double change = r.nsPerOp / base->second - 1;
+		bool isRegression = change > threshold;
+		regressions += isRegression;
+		printf("%-44s %14.1f %14.1f %+8.1f%%%s\n", r.name.c_str(), base->second, r.nsPerOp, change * 100, isRegression ? "  REGRESSION" : "");
+	}
+	printf("%d regression(s) over %.0f%%\n", regressions, threshold * 100);
+	return regressions == 0;
+}
+
+void Benchmark::consume(float value) {
+	floatSink = value;
+}
+
+void Benchmark::consume(const void* pointer) {
+	pointerSink = pointer;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// a small harness for the micro-benchmarks of the hot code, no window or GL context is needed
+// a benchmark calls its operation in batches until a repetition is long enough,
+// the median of the repetitions is the time of one operation
+// run RollerBench --help for the options, e.g. to compare with the CSV of another commit:
+//   RollerBench --csv before.csv            (on the old commit)
+//   RollerBench --compare before.csv        (on the new one, exit code 1 if something got slower)
+class Benchmark {
+public:
+	struct Result {
+		std::string name;
+		long long iterations;	// operations in a repetition
+		double nsPerOp;
+		double itemsPerSecond;
+	};
+
+	Benchmark(int argc, char** argv);
+
+	// false if the name is filtered out, or the options were wrong, to skip an expensive setup
+	bool isEnabled(const std::string& name) const;
+	// items is how many things one call of op handles, for the throughput
+	template <class Op>
+	void run(const std::string& name, double items, Op op);
+	// the print, the CSV and the comparison, return the exit code of the program
+	int finish();
+
+	// use a result, so the optimizer can't remove the work making it
+	static void consume(float value);
+	static void consume(const void* pointer);
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	std::string filter;
+	std::string csvPath;
+	std::string comparePath;
+	double minTime = 0.1;	// seconds of a repetition
+	int repetitions = 5;
+	double threshold = 0.1;	// a slow down over it is a regression
+	bool isValid = true;
+	std::vector<Result> results;
+
+	void record(const std::string& name, double items, long long iterations, std::vector<double>& seconds);
+	bool writeCSV() const;
+	bool compare() const;
+};
+
+template <class Op>
+void Benchmark::run(const std::string& name, double items, Op op) {
+	if (!isEnabled(name))
+		return;
+	// warm up, and find how many calls fill a repetition
+	long long iterations = 1;
+	while (true) {
+		Clock::time_point start = Clock::now();
+		for (long long i = 0; i < iterations; i++)
+			op();
+		double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+		if (elapsed >= minTime / 2 || iterations >= (1ll << 30))
+			break;
+		iterations *= elapsed > 0 ? std::max(2ll, std::min(100ll, (long long)(minTime / elapsed))) : 100;
+	}
+
+	std::vector<double> seconds;
+	for (int r = 0; r < repetitions; r++) {
+		Clock::time_point start = Clock::now();
+		for (long long i = 0; i < iterations; i++)
+			op();
+		seconds.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+	}
+	record(name, items, iterations, seconds);
+}
+
+// every file adds its benchmarks
+void addMathBenchmarks(Benchmark& bench);
+void addTrackBenchmarks(Benchmark& bench);
+void addParticleBenchmarks(Benchmark& bench);
+void addCollisionBenchmarks(Benchmark& bench);
+void addModelBenchmarks(Benchmark& bench);
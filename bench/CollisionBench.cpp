@@ -0,0 +1,57 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include "EntityStructure.H"
+#include "SpatialHash.h"
+#include "MathHelper.h"
+#include "Random.h"
+
+#define WORLD_SIZE 1000.0f
+#define ROCKET_AMOUNT 100
+#define ROCKET_STEP 10.0f	// distance a rocket flies in a tick
+
+// the test of TrainView::collisionJudge(), the hits are counted instead of exploding
+static int countHitsByHash(SpatialHash& hash, const RocketPool& rockets, const EntityPool& targets) {
+	int hits = 0;
+	rockets.findHits(targets, hash, [&](int, int) { hits++; });
+	return hits;
+}
+
+// every rocket against every target, what the spatial hash replaced
+static int countHitsByAllPairs(const RocketPool& rockets, const EntityPool& targets) {
+	int hits = 0;
+	for (int rocketID = 0; rocketID < rockets.size(); rocketID++) {
+		for (int targetID = 0; targetID < targets.size(); targetID++) {
+			hits += MathHelper::segmentIntersectCircle(rockets.pos[rocketID], rockets.lastPos[rocketID],
+				targets.pos[targetID], targets.front[targetID], TARGET_RADIUS);
+		}
+	}
+	return hits;
+}
+
+void addCollisionBenchmarks(Benchmark& bench) {
+	const int amounts[] = { 100, 1000, 10000 };
+	for (int amount : amounts) {
+		Random random(amount);
+		EntityPool targets(TARGET_SCALE);
+		for (int i = 0; i < amount; i++) {
+			glm::vec3 pos(random.nextFloat(0, WORLD_SIZE), random.nextFloat(0, WORLD_SIZE), random.nextFloat(0, WORLD_SIZE));
+			targets.add(Pnt3f(pos), Pnt3f(random.nextUnitVector()), Pnt3f(0, 1, 0));
+		}
+		RocketPool rockets;
+		for (int i = 0; i < ROCKET_AMOUNT; i++) {
+			glm::vec3 pos(random.nextFloat(0, WORLD_SIZE), random.nextFloat(0, WORLD_SIZE), random.nextFloat(0, WORLD_SIZE));
+			glm::vec3 front = random.nextUnitVector();
+			rockets.add(Pnt3f(pos + front * ROCKET_STEP), Pnt3f(front), Pnt3f(0, 1, 0));
+			rockets.lastPos.back() = Pnt3f(pos);
+		}
+
+		SpatialHash hash(TARGET_HASH_CELL_SIZE);
+		std::string suffix = std::to_string(amount) + "targets";
+		bench.run("collision/hash/" + suffix, ROCKET_AMOUNT, [&]() {
+			Benchmark::consume((float)countHitsByHash(hash, rockets, targets));
+		});
+		bench.run("collision/allPairs/" + suffix, ROCKET_AMOUNT, [&]() {
+			Benchmark::consume((float)countHitsByAllPairs(rockets, targets));
+		});
+	}
+}
@@ -0,0 +1,76 @@
+#include "Benchmark.h"
+#include <vector>
+#include "MathHelper.h"
+#include "Spline.h"
+#include "EntityStructure.H"
+#include "Random.h"
+
+#define SAMPLE_AMOUNT 1024	// parameters or matrices in one operation
+
+void addMathBenchmarks(Benchmark& bench) {
+	Random random(1);
+	std::vector<glm::vec3> pos(4), orient(4);
+	for (int i = 0; i < 4; i++) {
+		pos[i] = random.nextUnitVector() * 100.0f;
+		orient[i] = glm::vec3(0, 1, 0);
+	}
+	std::vector<float> t(SAMPLE_AMOUNT);
+	for (int i = 0; i < SAMPLE_AMOUNT; i++)
+		t[i] = (float)i / SAMPLE_AMOUNT;
+
+	// the control values times the basis once for the segment, then the polynomial for every axis of every point
+	bench.run("spline/GxM+MxT", SAMPLE_AMOUNT, [&]() {
+		float basis[16];
+		Spline::getBasisMatrix(Spline::CARDINAL, basis);
+		float points[3][4];
+		for (int axis = 0; axis < 3; axis++) {
+			for (int j = 0; j < 4; j++)
+				points[axis][j] = pos[j][axis];
+			MathHelper::GxM(points[axis], basis);
+		}
+		float sum = 0;
+		for (int i = 0; i < SAMPLE_AMOUNT; i++) {
+			for (int axis = 0; axis < 3; axis++)
+				sum += MathHelper::MxT(points[axis], t[i]);
+		}
+		Benchmark::consume(sum);
+	});
+
+	// the same curve by the precomputed segment of the track tessellator
+	Spline::Segment segment;
+	Spline::buildSegments(Spline::CARDINAL, pos.data(), orient.data(), 4, &segment);
+	std::vector<glm::vec3> outPos(SAMPLE_AMOUNT), outTangent(SAMPLE_AMOUNT), outOrient(SAMPLE_AMOUNT);
+	bench.run("spline/Spline::evaluate", SAMPLE_AMOUNT, [&]() {
+		Spline::evaluate(segment, t.data(), SAMPLE_AMOUNT, outPos.data(), outTangent.data(), outOrient.data());
+		Benchmark::consume(outPos.data());
+	});
+
+	std::vector<glm::vec3> positions(SAMPLE_AMOUNT), fronts(SAMPLE_AMOUNT);
+	for (int i = 0; i < SAMPLE_AMOUNT; i++) {
+		positions[i] = random.nextUnitVector() * 500.0f;
+		fronts[i] = random.nextUnitVector();
+	}
+	std::vector<glm::mat4> matrices(SAMPLE_AMOUNT), normals(SAMPLE_AMOUNT);
+	bench.run("matrix/getTransformMatrix", SAMPLE_AMOUNT, [&]() {
+		for (int i = 0; i < SAMPLE_AMOUNT; i++)
+			matrices[i] = MathHelper::getTransformMatrix(positions[i], fronts[i], glm::vec3(0, 1, 0), glm::vec3(10, 0.5, 2));
+		Benchmark::consume(matrices.data());
+	});
+
+	// what InstanceMatrices::add does for every sleeper and pier
+	bench.run("matrix/getTransformMatrix+normal", SAMPLE_AMOUNT, [&]() {
+		for (int i = 0; i < SAMPLE_AMOUNT; i++) {
+			matrices[i] = MathHelper::getTransformMatrix(positions[i], fronts[i], glm::vec3(0, 1, 0), glm::vec3(10, 0.5, 2));
+			normals[i] = glm::transpose(glm::inverse(matrices[i]));
+		}
+		Benchmark::consume(normals.data());
+	});
+
+	EntityPool pool(TARGET_SCALE);
+	for (int i = 0; i < SAMPLE_AMOUNT; i++)
+		pool.add(Pnt3f(positions[i]), Pnt3f(fronts[i]), Pnt3f(0, 1, 0));
+	bench.run("matrix/EntityPool::updateMatrices", SAMPLE_AMOUNT, [&]() {
+		pool.updateMatrices(0, pool.size());
+		Benchmark::consume(pool.normal.data());
+	});
+}
@@ -0,0 +1,41 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+
+// the import of Model::loadModel(), the meshes and textures are not uploaded because there is no GL context
+#define MODEL_IMPORT_FLAGS (aiProcess_Triangulate | aiProcess_FlipUVs)
+
+void addModelBenchmarks(Benchmark& bench) {
+	std::vector<std::filesystem::path> paths;
+	for (const auto& entry : std::filesystem::recursive_directory_iterator(PROJECT_DIR "/assets/model")) {
+		if (entry.path().extension() == ".obj")
+			paths.push_back(entry.path());
+	}
+	std::sort(paths.begin(), paths.end());
+
+	for (const std::filesystem::path& path : paths) {
+		std::string name = "model/" + path.parent_path().filename().string() + "/" + path.stem().string();
+		if (!bench.isEnabled(name))
+			continue;
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(path.string(), MODEL_IMPORT_FLAGS);
+		if (scene == nullptr || scene->mRootNode == nullptr) {
+			printf("can't import %s: %s\n", path.string().c_str(), importer.GetErrorString());
+			continue;
+		}
+		// the throughput is in vertices
+		double vertices = 0;
+		for (unsigned int i = 0; i < scene->mNumMeshes; i++)
+			vertices += scene->mMeshes[i]->mNumVertices;
+
+		bench.run(name, vertices, [&]() {
+			Assimp::Importer importer;
+			Benchmark::consume(importer.ReadFile(path.string(), MODEL_IMPORT_FLAGS));
+		});
+	}
+}
@@ -0,0 +1,34 @@
+#include "Benchmark.h"
+#include "FrameArena.h"
+#include "RenderUnit/ParticleSystem.h"
+
+#define PARTICLE_LIFE 100
+
+void addParticleBenchmarks(Benchmark& bench) {
+	const int amounts[] = { 1000, 10000, 100000 };
+	for (int amount : amounts) {
+		std::string name = "particles/update/" + std::to_string(amount);
+		if (!bench.isEnabled(name))
+			continue;
+		// as many particles are born as die in a tick, so the amount stays the same
+		ParticleGenerator generator(nullptr, 0);
+		generator.setGenerateRate((float)amount / PARTICLE_LIFE);
+		generator.setParticleLife(PARTICLE_LIFE);
+		generator.setParticleVelocity(1);
+		generator.setParticleVelocityRandomOffset(0.5f);
+		generator.setAngle(40);
+		generator.setGravity(0.01f);
+		generator.setFriction(0.99f);
+		generator.setColor(glm::vec3(1.0, 1.0, 0.0), glm::vec3(1.0, 0.0, 0.0), glm::vec3(0.5, 0.5, 0.5), 0.5);
+		for (int i = 0; i < PARTICLE_LIFE; i++) {
+			FrameArena::resetAll();
+			generator.update();
+		}
+
+		bench.run(name, amount, [&]() {
+			FrameArena::resetAll();
+			generator.update();
+		});
+	}
+	FrameArena::resetAll();
+}
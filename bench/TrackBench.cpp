@@ -0,0 +1,86 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <vector>
+#include "TrackTessellator.h"
+#include "FrameArena.h"
+#include "RenderUnit/InstanceDrawer.h"
+
+// the format of CTrack::readPoints(), which can't be used without FLTK
+static bool readTrack(const std::string& path, std::vector<ControlPoint>& points) {
+	FILE* file = fopen(path.c_str(), "r");
+	if (file == nullptr)
+		return false;
+	char line[512];
+	int amount = fgets(line, sizeof(line), file) ? atoi(line) : 0;
+	points.clear();
+	while ((int)points.size() < amount && fgets(line, sizeof(line), file)) {
+		Pnt3f pos(0, 0, 0), orient(0, 1, 0);
+		int read = sscanf(line, "%f %f %f %f %f %f", &pos.x, &pos.y, &pos.z, &orient.x, &orient.y, &orient.z);
+		if (read < 6)
+			orient = Pnt3f(0, 1, 0);
+		if (read < 3)
+			pos = Pnt3f(0, 0, 0);
+		orient.normalize();
+		points.push_back(ControlPoint(pos, orient));
+	}
+	fclose(file);
+	return amount >= 4;
+}
+
+// the sleepers and piers of TrainView::drawStuff(), with every chunk visible
+static int makeTrackInstances(const TrackTessellator& tessellator, InstanceMatrices& sleepers, InstanceMatrices& piers) {
+	for (int i = 0; i < tessellator.getSleeperAmount(); i++)
+		sleepers.add(tessellator.getSleeperMatrix(i));
+	glm::mat4 matrices[2];
+	for (int i = 0; i < tessellator.getPierAmount(); i++) {
+		int amount = tessellator.getPierMatrices(i, matrices);
+		for (int j = 0; j < amount; j++)
+			piers.add(matrices[j]);
+	}
+	return (int)(sleepers.modelMatrices.size() + piers.modelMatrices.size());
+}
+
+void addTrackBenchmarks(Benchmark& bench) {
+	std::vector<std::string> paths;
+	for (const auto& entry : std::filesystem::directory_iterator(PROJECT_DIR "/TrackFiles")) {
+		if (entry.path().extension() == ".txt")
+			paths.push_back(entry.path().string());
+	}
+	std::sort(paths.begin(), paths.end());
+
+	for (const std::string& path : paths) {
+		std::vector<ControlPoint> points;
+		if (!readTrack(path, points)) {
+			printf("can't read the track %s\n", path.c_str());
+			continue;
+		}
+		std::string name = std::filesystem::path(path).stem().string();
+
+		// a new tessellator every time, so nothing is cached
+		TrackTessellator tessellator;
+		tessellator.update(points, Spline::CARDINAL, TrackTessellator::DEFAULT_TOLERANCE);
+		bench.run("track/" + name + "/tessellate", (double)tessellator.getSamples().size(), [&]() {
+			TrackTessellator rebuilt;
+			rebuilt.update(points, Spline::CARDINAL, TrackTessellator::DEFAULT_TOLERANCE);
+			Benchmark::consume(rebuilt.getTotalLength());
+		});
+
+		FrameArena::resetAll();
+		int instanceAmount;
+		{
+			InstanceMatrices sleepers, piers;
+			instanceAmount = makeTrackInstances(tessellator, sleepers, piers);
+		}
+		bench.run("track/" + name + "/instances", instanceAmount, [&]() {
+			// the matrices are on the frame arena like in a frame
+			FrameArena::resetAll();
+			InstanceMatrices sleepers, piers;
+			makeTrackInstances(tessellator, sleepers, piers);
+			Benchmark::consume(sleepers.modelMatrices.data());
+		});
+	}
+	FrameArena::resetAll();
+}
@@ -0,0 +1,213 @@
+#include "AllocTracker.h"
+
+#ifdef TRACK_ALLOCATIONS
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#if defined(_MSC_VER) && defined(_DEBUG)
+#include <crtdbg.h>
+#endif
+
+#define ALLOC_REPORT_INTERVAL 60
+#define ALLOC_CSV_PATH "allocations.csv"
+// in front of every block from operator new, keep the size and the alignment of the block
+#define ALLOC_HEADER_SIZE 16
+
+static const char* TAG_NAMES[ALLOC_TAG_AMOUNT] = {
+	"other", "track build", "particles", "entities", "shader uniforms", "asset loading"
+};
+
+// nothing here may allocate, they are used inside operator new
+static thread_local AllocTag currentAllocTag = ALLOC_OTHER;
+static thread_local bool insideNew = false;	// so the malloc hook does not count new twice
+static std::atomic<long long> frameCount[ALLOC_TAG_AMOUNT];
+static std::atomic<long long> frameBytes[ALLOC_TAG_AMOUNT];
+static std::atomic<long long> frameFrees;
+static std::atomic<long long> liveBytes;
+static std::atomic<long long> framePeak;
+static long long frameNumber = 0;
+static FILE* csvFile = nullptr;
+
+//---------------Tracker-----------------
+
+AllocTag AllocTracker::currentTag() {
+	return currentAllocTag;
+}
+
+void AllocTracker::setTag(AllocTag tag) {
+	currentAllocTag = tag;
+}
+
+void AllocTracker::recordAllocation(size_t size) {
+	frameCount[currentAllocTag]++;
+	frameBytes[currentAllocTag] += size;
+	long long live = liveBytes += size;
+	long long peak = framePeak;
+	while (live > peak && !framePeak.compare_exchange_weak(peak, live)) {
+	}
+}
+
+void AllocTracker::recordFree(size_t size) {
+	frameFrees++;
+	liveBytes -= size;
+}
+
+#if defined(_MSC_VER) && defined(_DEBUG)
+// malloc, realloc and free which do not come from operator new, the size of a free is unknown here
+static int crtAllocHook(int allocType, void*, size_t size, int blockType, long, const unsigned char*, int) {
+	if (insideNew || blockType == _CRT_BLOCK)
+		return TRUE;
+	if (allocType == _HOOK_ALLOC || allocType == _HOOK_REALLOC) {
+		frameCount[currentAllocTag]++;
+		frameBytes[currentAllocTag] += size;
+	}
+	else if (allocType == _HOOK_FREE)
+		frameFrees++;
+	return TRUE;
+}
+#endif
+
+void AllocTracker::beginFrame() {
+#if defined(_MSC_VER) && defined(_DEBUG)
+	static bool hookInstalled = false;
+	if (!hookInstalled) {
+		_CrtSetAllocHook(crtAllocHook);
+		hookInstalled = true;
+	}
+#endif
+}
+
+// the idle ticks between two draws count for the next frame
+static void resetCounters() {
+	for (int i = 0; i < ALLOC_TAG_AMOUNT; i++) {
+		frameCount[i] = 0;
+		frameBytes[i] = 0;
+	}
+	frameFrees = 0;
+	framePeak = liveBytes.load();
+}
+
+void AllocTracker::endFrame() {
+	long long count[ALLOC_TAG_AMOUNT], bytes[ALLOC_TAG_AMOUNT];
+	long long totalCount = 0, totalBytes = 0;
+	for (int i = 0; i < ALLOC_TAG_AMOUNT; i++) {
+		count[i] = frameCount[i];
+		bytes[i] = frameBytes[i];
+		totalCount += count[i];
+		totalBytes += bytes[i];
+	}
+	long long frees = frameFrees;
+	long long peak = framePeak;
+
+	// the report itself allocates, keep it out of the next frame
+	AllocScope scope(ALLOC_OTHER);
+	if (csvFile == nullptr) {
+		csvFile = fopen(ALLOC_CSV_PATH, "w");
+		if (csvFile != nullptr) {
+			fprintf(csvFile, "frame");
+			for (int i = 0; i < ALLOC_TAG_AMOUNT; i++)
+				fprintf(csvFile, ",%s count,%s bytes", TAG_NAMES[i], TAG_NAMES[i]);
+			fprintf(csvFile, ",frees,peak bytes\n");
+		}
+	}
+	if (csvFile != nullptr) {
+		fprintf(csvFile, "%lld", frameNumber);
+		for (int i = 0; i < ALLOC_TAG_AMOUNT; i++)
+			fprintf(csvFile, ",%lld,%lld", count[i], bytes[i]);
+		fprintf(csvFile, ",%lld,%lld\n", frees, peak);
+		fflush(csvFile);
+	}
+
+	if (frameNumber % ALLOC_REPORT_INTERVAL == 0) {
+		printf("[alloc] frame %lld: %lld allocations, %lld bytes, %lld frees, peak %lld bytes\n", frameNumber, totalCount, totalBytes, frees, peak);
+		for (int i = 0; i < ALLOC_TAG_AMOUNT; i++) {
+			if (count[i] > 0)
+				printf("[alloc]   %-16s %8lld allocations %12lld bytes\n", TAG_NAMES[i], count[i], bytes[i]);
+		}
+	}
+	frameNumber++;
+	resetCounters();
+}
+
+//---------------Scope-----------------
+
+AllocScope::AllocScope(AllocTag tag) {
+	lastTag = currentAllocTag;
+	currentAllocTag = tag;
+}
+
+AllocScope::~AllocScope() {
+	currentAllocTag = lastTag;
+}
+
+//---------------Hooks-----------------
+
+static void* trackedNew(size_t size) {
+	insideNew = true;
+	char* block = static_cast<char*>(std::malloc(size + ALLOC_HEADER_SIZE));
+	insideNew = false;
+	if (block == nullptr)
+		return nullptr;
+	*reinterpret_cast<size_t*>(block) = size;
+	AllocTracker::recordAllocation(size);
+	return block + ALLOC_HEADER_SIZE;
+}
+
+static void trackedDelete(void* p) {
+	if (p == nullptr)
+		return;
+	char* block = static_cast<char*>(p) - ALLOC_HEADER_SIZE;
+	AllocTracker::recordFree(*reinterpret_cast<size_t*>(block));
+	insideNew = true;
+	std::free(block);
+	insideNew = false;
+}
+
+void* operator new(size_t size) {
+	void* p = trackedNew(size);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new[](size_t size) {
+	void* p = trackedNew(size);
+	if (p == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return trackedNew(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return trackedNew(size);
+}
+
+void operator delete(void* p) noexcept {
+	trackedDelete(p);
+}
+
+void operator delete[](void* p) noexcept {
+	trackedDelete(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	trackedDelete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+	trackedDelete(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+	trackedDelete(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+	trackedDelete(p);
+}
+
+#endif
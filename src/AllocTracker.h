@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+
+// opt-in heap allocation tracking, configure with -DTRACK_ALLOCATIONS=ON
+// global operator new/delete (and malloc in MSVC debug builds) are hooked,
+// every allocation is counted for the tag of the scope it is made in
+// a line is printed every ALLOC_REPORT_INTERVAL frames, and every frame is written to ALLOC_CSV_PATH
+enum AllocTag {
+	ALLOC_OTHER,
+	ALLOC_TRACK_BUILD,
+	ALLOC_PARTICLES,
+	ALLOC_ENTITIES,
+	ALLOC_SHADER_UNIFORMS,
+	ALLOC_ASSET_LOADING,
+	ALLOC_TAG_AMOUNT
+};
+
+#ifdef TRACK_ALLOCATIONS
+
+class AllocTracker {
+public:
+	static AllocTag currentTag();
+	static void setTag(AllocTag tag);
+
+	// called by the hooks
+	static void recordAllocation(size_t size);
+	static void recordFree(size_t size);
+
+	// a frame counts everything since the end of the last one, so the ticks between draws are in it too
+	static void beginFrame();
+	static void endFrame();
+};
+
+// count the allocations in this scope for the tag, and set the last tag back after
+class AllocScope {
+public:
+	AllocScope(AllocTag tag);
+	~AllocScope();
+
+private:
+	AllocTag lastTag;
+};
+
+#define ALLOC_CONCAT_INNER(a, b) a##b
+#define ALLOC_CONCAT(a, b) ALLOC_CONCAT_INNER(a, b)
+#define ALLOC_SCOPE(tag) AllocScope ALLOC_CONCAT(allocScope, __LINE__)(tag)
+#define ALLOC_BEGIN_FRAME() AllocTracker::beginFrame()
+#define ALLOC_END_FRAME() AllocTracker::endFrame()
+
+#else
+
+#define ALLOC_SCOPE(tag)
+#define ALLOC_BEGIN_FRAME()
+#define ALLOC_END_FRAME()
+
+#endif
@@ -26,6 +26,7 @@
 #include "TrainWindow.H"
 #include "TrainView.H"
 #include "CallBacks.H"
+#include "InputRecorder.h"
 
 #pragma warning(push)
 #pragma warning(disable:4312)
@@ -134,6 +135,11 @@ static unsigned long lastRedraw = 0;
 void runButtonCB(TrainWindow* tw)
 //===========================================================================
 {
+	// the ticks of a replay come from the recording, just draw as fast as possible
+	if (InputRecorder::get().getMode() == InputRecorder::REPLAYING) {
+		tw->damageMe();
+		return;
+	}
 	if (tw->runButton->value()) {	// only advance time if appropriate
 		if (clock() - lastRedraw > CLOCKS_PER_SEC/30) {
 			lastRedraw = clock();
@@ -257,4 +263,21 @@ void addMoreTargetCB(Fl_Widget*, TrainWindow* tw)
 //===========================================================================
 {
 	tw->trainView->addMoreTarget();
+}
+
+//***************************************************************************
+//
+// * every camera remember its own occlusion setting
+//===========================================================================
+void cameraCB(Fl_Widget*, TrainWindow* tw)
+//===========================================================================
+{
+	tw->occlusionCull->value(tw->occlusionPerCamera[tw->cameraIndex()]);
+	tw->damageMe();
+}
+void occlusionCB(Fl_Widget*, TrainWindow* tw)
+//===========================================================================
+{
+	tw->occlusionPerCamera[tw->cameraIndex()] = tw->occlusionCull->value() != 0;
+	tw->damageMe();
 }
\ No newline at end of file
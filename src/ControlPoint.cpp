@@ -31,40 +31,6 @@
 #include "ControlPoint.H"
 #include "Utilities/3dUtils.h"
 
-//****************************************************************************
-//
-// * Default contructor
-//============================================================================
-ControlPoint::
-ControlPoint() 
-	: pos(0,0,0), orient(0,1,0)
-//============================================================================
-{
-}
-
-//****************************************************************************
-//
-// * Set up the position and set orientation to default (0, 1, 0)
-//============================================================================
-ControlPoint::
-ControlPoint(const Pnt3f &_pos) 
-	: pos(_pos), orient(0,1,0)
-//============================================================================
-{
-}
-
-//****************************************************************************
-//
-// * Set up the position and orientation
-//============================================================================
-ControlPoint::
-ControlPoint(const Pnt3f &_pos, const Pnt3f &_orient) 
-	: pos(_pos), orient(_orient)
-//============================================================================
-{
-	orient.normalize();
-}
-
 //****************************************************************************
 //
 // * Draw the control point
@@ -0,0 +1,170 @@
+#include "EntityStructure.H"
+#include <cmath>
+#include "MathHelper.h"
+#include "RenderUnit/RenderStructure.h"
+
+#define ROCKET_HEAD_SCALE glm::vec3(4, 4, 3)
+#define ROCKET_BODY_SCALE glm::vec3(3.5, 3.5, 8)
+#define ROCKET_BODY_OFFSET -5.5f
+
+//---------------Entity Pool-----------------
+
+EntityPool::EntityPool(glm::vec3 scale) {
+	this->scale = scale;
+}
+
+EntityHandle EntityPool::add(Pnt3f pos, Pnt3f front, Pnt3f up) {
+	int index = size();
+	int slot;
+	if (freeSlots.empty()) {
+		slot = (int)indexOfSlot.size();
+		indexOfSlot.push_back(index);
+		generation.push_back(0);
+	}
+	else {
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+		indexOfSlot[slot] = index;
+	}
+	slotOfIndex.push_back(slot);
+
+	this->pos.push_back(pos);
+	this->front.push_back(front);
+	this->up.push_back(up);
+	velocity.push_back(Pnt3f(0, 0, 0));
+	state.push_back(0);
+	world.push_back(glm::mat4(1.0f));
+	normal.push_back(glm::mat4(1.0f));
+	pushExtra();
+	updateMatrices(index, index + 1);
+
+	EntityHandle handle;
+	handle.slot = slot;
+	handle.generation = generation[slot];
+	return handle;
+}
+
+void EntityPool::remove(int index) {
+	int last = size() - 1;
+	int slot = slotOfIndex[index];
+	if (index != last) {
+		pos[index] = pos[last];
+		front[index] = front[last];
+		up[index] = up[last];
+		velocity[index] = velocity[last];
+		state[index] = state[last];
+		world[index] = world[last];
+		normal[index] = normal[last];
+		moveExtra(index, last);
+		slotOfIndex[index] = slotOfIndex[last];
+		indexOfSlot[slotOfIndex[index]] = index;
+	}
+	pos.pop_back();
+	front.pop_back();
+	up.pop_back();
+	velocity.pop_back();
+	state.pop_back();
+	world.pop_back();
+	normal.pop_back();
+	popExtra();
+	slotOfIndex.pop_back();
+
+	indexOfSlot[slot] = -1;
+	generation[slot]++;
+	freeSlots.push_back(slot);
+}
+
+void EntityPool::clear() {
+	while (size() > 0)
+		remove(size() - 1);
+}
+
+int EntityPool::size() const {
+	return (int)pos.size();
+}
+
+EntityHandle EntityPool::getHandle(int index) const {
+	EntityHandle handle;
+	handle.slot = slotOfIndex[index];
+	handle.generation = generation[handle.slot];
+	return handle;
+}
+
+int EntityPool::indexOf(EntityHandle handle) const {
+	if (handle.slot < 0 || handle.slot >= (int)indexOfSlot.size() || generation[handle.slot] != handle.generation)
+		return -1;
+	return indexOfSlot[handle.slot];
+}
+
+void EntityPool::updateMatrices(int first, int last) {
+	for (int i = first; i < last; i++) {
+		world[i] = MathHelper::getTransformMatrix(pos[i].glmvec3(), front[i].glmvec3(), up[i].glmvec3(), scale);
+		normal[i] = glm::transpose(glm::inverse(world[i]));
+	}
+}
+
+//---------------Rocket Pool-----------------
+
+RocketPool::RocketPool() : EntityPool(ROCKET_HEAD_SCALE) {
+}
+
+void RocketPool::advance(int index) {
+	Pnt3f& thrusterVelocity = velocity[index];
+	lastPos[index] = pos[index];
+	pos[index] = pos[index] + (thrusterVelocity + gravityVelocity[index]) * RenderDatabase::timeScale;
+	if (thrusterVelocity.len2() < 100)
+		thrusterVelocity = thrusterVelocity * std::pow(1.15, RenderDatabase::timeScale);	// accelerate
+	gravityVelocity[index].y -= 0.2 * RenderDatabase::timeScale;	// g
+	front[index] = thrusterVelocity + gravityVelocity[index];
+	Pnt3f right = front[index] * up[index];
+	up[index] = right * front[index];
+	// if you don't normalize it, something cool will happend
+	front[index].normalize();
+	up[index].normalize();
+}
+
+glm::mat4 RocketPool::getBodyMatrix(int index) const {
+	Pnt3f bodyPos = pos[index] + front[index] * ROCKET_BODY_OFFSET;
+	Pnt3f bodyFront = front[index];
+	Pnt3f bodyUp = up[index];
+	return MathHelper::getTransformMatrix(bodyPos.glmvec3(), bodyFront.glmvec3(), bodyUp.glmvec3(), ROCKET_BODY_SCALE);
+}
+
+void RocketPool::pushExtra() {
+	gravityVelocity.push_back(Pnt3f(0, 0, 0));
+	lastPos.push_back(pos.back());
+}
+
+void RocketPool::moveExtra(int to, int from) {
+	gravityVelocity[to] = gravityVelocity[from];
+	lastPos[to] = lastPos[from];
+}
+
+void RocketPool::popExtra() {
+	gravityVelocity.pop_back();
+	lastPos.pop_back();
+}
+
+//---------------Fragment Pool-----------------
+
+FragmentPool::FragmentPool() : EntityPool(TARGET_SCALE) {
+}
+
+void FragmentPool::advance(int index) {
+	pos[index] = pos[index] + velocity[index] * RenderDatabase::timeScale;
+	velocity[index] = velocity[index] * (1 - (std::pow(0.005, 1 / RenderDatabase::timeScale)));
+	velocity[index].y -= 0.1 * RenderDatabase::timeScale;	// g
+	// Todo: rotate it
+}
+
+void FragmentPool::pushExtra() {
+	angularVelocity.push_back(Pnt3f(0, 0, 0));
+}
+
+void FragmentPool::moveExtra(int to, int from) {
+	angularVelocity[to] = angularVelocity[from];
+}
+
+void FragmentPool::popExtra() {
+	angularVelocity.pop_back();
+}
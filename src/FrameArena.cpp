@@ -0,0 +1,88 @@
+#include "FrameArena.h"
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include "JobSystem.h"
+
+// one arena for every thread index of the job system
+static std::vector<std::unique_ptr<FrameArena>> makeArenas() {
+	std::vector<std::unique_ptr<FrameArena>> arenas;
+	for (int i = 0; i < JobSystem::get().getThreadAmount(); i++)
+		arenas.push_back(std::unique_ptr<FrameArena>(new FrameArena()));
+	return arenas;
+}
+
+static std::vector<std::unique_ptr<FrameArena>>& allArenas() {
+	static std::vector<std::unique_ptr<FrameArena>> arenas = makeArenas();
+	return arenas;
+}
+
+FrameArena& FrameArena::get() {
+	return *allArenas()[JobSystem::threadIndex()];
+}
+
+void FrameArena::resetAll() {
+	for (auto& arena : allArenas())
+		arena->reset();
+}
+
+FrameArena::FrameArena() {
+}
+
+FrameArena::~FrameArena() {
+	for (auto& block : blocks)
+		std::free(block.data);
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+	if (size == 0)
+		size = 1;
+	while (current < blocks.size()) {
+		Block& block = blocks[current];
+		size_t start = (offset + alignment - 1) & ~(alignment - 1);
+		if (start + size <= block.size) {
+			offset = start + size;
+			return block.data + start;
+		}
+		// the rest of this block is wasted in this frame
+		usedBefore += block.size;
+		current++;
+		offset = 0;
+	}
+	addBlock(size + alignment > DEFAULT_BLOCK_SIZE ? size + alignment : DEFAULT_BLOCK_SIZE);
+	return allocate(size, alignment);
+}
+
+void FrameArena::reset() {
+	if (blocks.size() > 1) {
+		size_t total = 0;
+		for (auto& block : blocks) {
+			total += block.size;
+			std::free(block.data);
+		}
+		blocks.clear();
+		addBlock(total);
+	}
+	current = 0;
+	offset = 0;
+	usedBefore = 0;
+}
+
+size_t FrameArena::getUsed() const {
+	return usedBefore + offset;
+}
+
+size_t FrameArena::getCapacity() const {
+	size_t total = 0;
+	for (auto& block : blocks)
+		total += block.size;
+	return total;
+}
+
+void FrameArena::addBlock(size_t size) {
+	// malloc is aligned for any fundamental type
+	Block block = { static_cast<char*>(std::malloc(size)), size };
+	if (block.data == nullptr)
+		throw std::bad_alloc();
+	blocks.push_back(block);
+}
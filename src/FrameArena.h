@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// linear allocator for data which only live in one frame
+// every thread has its own arena, so jobs can use it without locks
+// all arenas are reset at the start of a frame, nothing allocated from them may be kept after that
+class FrameArena {
+public:
+	static const size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+	// arena of the calling thread
+	static FrameArena& get();
+	// start a new frame, no job may be running
+	static void resetAll();
+
+	FrameArena();
+	~FrameArena();
+
+	void* allocate(size_t size, size_t alignment);
+	// forget everything, if more than one block was used they are merged into one big enough for all
+	void reset();
+
+	size_t getUsed() const;
+	size_t getCapacity() const;
+
+private:
+	struct Block {
+		char* data;
+		size_t size;
+	};
+	std::vector<Block> blocks;
+	size_t current = 0;	// block in use
+	size_t offset = 0;	// in the block in use
+	size_t usedBefore = 0;	// bytes of the full blocks before the current one
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	void addBlock(size_t size);
+};
+
+// std allocator on the frame arena of the allocating thread, deallocate does nothing
+template <class T>
+class ArenaAllocator {
+public:
+	typedef T value_type;
+
+	ArenaAllocator() {}
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U>&) {}
+
+	T* allocate(size_t n) {
+		return static_cast<T*>(FrameArena::get().allocate(n * sizeof(T), alignof(T)));
+	}
+	void deallocate(T*, size_t) {}
+
+	template <class U>
+	bool operator==(const ArenaAllocator<U>&) const { return true; }
+	template <class U>
+	bool operator!=(const ArenaAllocator<U>&) const { return false; }
+};
+
+template <class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>> ArenaString;
@@ -0,0 +1,337 @@
+#include "FrameCapture.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstring>
+
+#define VIDEO_FRAME_RATE "30:1"	// the fixed time step of TrainWindow::advanceTrain()
+#define STORED_BLOCK_SIZE 65535	// the most bytes of a stored deflate block
+
+static unsigned int crcTable[256];
+
+static void makeCrcTable() {
+	for (unsigned int n = 0; n < 256; n++) {
+		unsigned int c = n;
+		for (int k = 0; k < 8; k++)
+			c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+		crcTable[n] = c;
+	}
+}
+
+static unsigned int updateCrc(unsigned int crc, const unsigned char* data, size_t size) {
+	for (size_t i = 0; i < size; i++)
+		crc = crcTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return crc;
+}
+
+static void putBigEndian(std::vector<unsigned char>& out, unsigned int value) {
+	out.push_back((unsigned char)(value >> 24));
+	out.push_back((unsigned char)(value >> 16));
+	out.push_back((unsigned char)(value >> 8));
+	out.push_back((unsigned char)value);
+}
+
+static void writeChunk(FILE* file, const char* type, const unsigned char* data, size_t size) {
+	unsigned char length[4] = { (unsigned char)(size >> 24), (unsigned char)(size >> 16), (unsigned char)(size >> 8), (unsigned char)size };
+	fwrite(length, 1, 4, file);
+	fwrite(type, 1, 4, file);
+	if (size > 0)
+		fwrite(data, 1, size, file);
+	unsigned int crc = updateCrc(0xFFFFFFFFu, (const unsigned char*)type, 4);
+	crc = updateCrc(crc, data, size) ^ 0xFFFFFFFFu;
+	unsigned char crcBytes[4] = { (unsigned char)(crc >> 24), (unsigned char)(crc >> 16), (unsigned char)(crc >> 8), (unsigned char)crc };
+	fwrite(crcBytes, 1, 4, file);
+}
+
+FrameCapture& FrameCapture::get() {
+	static FrameCapture capture;
+	return capture;
+}
+
+FrameCapture::~FrameCapture() {
+	stop();
+}
+
+bool FrameCapture::start(const char* path) {
+	stop();
+	size_t length = strlen(path);
+	format = length > 4 && strcmp(path + length - 4, ".y4m") == 0 ? Y4M : PNG;
+	this->path = path;
+	if (format == Y4M) {
+		video = fopen(path, "wb");
+		if (video == nullptr) {
+			printf("[capture] can't open %s\n", path);
+			return false;
+		}
+		videoWidth = videoHeight = 0;
+	}
+	makeCrcTable();
+	frames = 0;
+	hasStalled = false;
+	isQuitting = false;
+	writer = std::thread(&FrameCapture::writerLoop, this);
+	capturing = true;
+	printf("[capture] capturing to %s\n", path);
+	return true;
+}
+
+void FrameCapture::stop() {
+	if (!capturing)
+		return;
+	capturing = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		isQuitting = true;
+	}
+	workReady.notify_one();
+	writer.join();
+
+	// no GL context here, the fences are deleted when the slots are used again
+	int lost = 0;
+	for (int i = 0; i < RING_SIZE; i++) {
+		if (slots[i].state == READING) {
+			slots[i].state = FREE;
+			lost++;
+		}
+	}
+	if (video != nullptr) {
+		fclose(video);
+		video = nullptr;
+	}
+	printf("[capture] done, %d frames", frames - lost);
+	if (lost > 0)
+		printf(", the last %d not read back yet", lost);
+	printf("\n");
+}
+
+bool FrameCapture::createBuffers(int width, int height) {
+	this->width = width;
+	this->height = height;
+	GLsizeiptr size = (GLsizeiptr)width * height * 4;
+	const GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	for (int i = 0; i < RING_SIZE; i++) {
+		glGenBuffers(1, &slots[i].PBO);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slots[i].PBO);
+		glBufferStorage(GL_PIXEL_PACK_BUFFER, size, nullptr, flags);
+		slots[i].pixels = (unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, flags);
+		if (slots[i].pixels == nullptr) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			printf("[capture] can't map the read back buffers\n");
+			releaseBuffers();
+			return false;
+		}
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	nextSlot = 0;
+	return true;
+}
+
+void FrameCapture::releaseBuffers() {
+	for (int i = 0; i < RING_SIZE; i++) {
+		if (slots[i].fence != nullptr) {
+			glDeleteSync((GLsync)slots[i].fence);
+			slots[i].fence = nullptr;
+		}
+		if (slots[i].PBO != 0) {
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, slots[i].PBO);
+			if (slots[i].pixels != nullptr)
+				glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+			glDeleteBuffers(1, &slots[i].PBO);
+		}
+		slots[i] = Slot();
+	}
+	width = height = 0;
+}
+
+void FrameCapture::handOff(bool wait) {
+	bool isHanded = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		// the ring is used in order, the oldest frame is in the next slot
+		for (int i = 0; i < RING_SIZE; i++) {
+			Slot& slot = slots[(nextSlot + i) % RING_SIZE];
+			if (slot.state != READING)
+				continue;
+			GLenum result = glClientWaitSync((GLsync)slot.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? GL_TIMEOUT_IGNORED : 0);
+			if (result == GL_TIMEOUT_EXPIRED)
+				break;
+			glDeleteSync((GLsync)slot.fence);
+			slot.fence = nullptr;
+			slot.state = WRITING;
+			queue.push_back((nextSlot + i) % RING_SIZE);
+			isHanded = true;
+		}
+	}
+	if (isHanded)
+		workReady.notify_one();
+}
+
+void FrameCapture::captureFrame(int width, int height) {
+	if (!capturing || width <= 0 || height <= 0)
+		return;
+
+	if (width != this->width || height != this->height) {
+		// the writer must be done with the old buffers
+		handOff(true);
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			slotFreed.wait(lock, [this] { return queue.empty() && std::all_of(slots, slots + RING_SIZE, [](const Slot& slot) { return slot.state != WRITING; }); });
+		}
+		releaseBuffers();
+		if (!createBuffers(width, height)) {
+			stop();
+			return;
+		}
+	}
+
+	handOff(false);
+	Slot& slot = slots[nextSlot];
+	if (slot.state == READING)
+		handOff(true);
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (slot.state == WRITING && !hasStalled) {
+			printf("[capture] the writer is behind, the draw waits for it\n");
+			hasStalled = true;
+		}
+		slotFreed.wait(lock, [&slot] { return slot.state == FREE; });
+	}
+	// left by a stopped capture
+	if (slot.fence != nullptr) {
+		glDeleteSync((GLsync)slot.fence);
+		slot.fence = nullptr;
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glReadBuffer(GL_BACK);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.PBO);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.frame = frames++;
+	slot.state = READING;
+	nextSlot = (nextSlot + 1) % RING_SIZE;
+}
+
+void FrameCapture::writerLoop() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		workReady.wait(lock, [this] { return !queue.empty() || isQuitting; });
+		if (queue.empty())
+			break;
+		int index = queue.front();
+		queue.pop_front();
+		const unsigned char* pixels = slots[index].pixels;
+		int frame = slots[index].frame;
+		int frameWidth = width, frameHeight = height;
+
+		lock.unlock();
+		writeFrame(pixels, frame, frameWidth, frameHeight);
+		lock.lock();
+		slots[index].state = FREE;
+		slotFreed.notify_one();
+	}
+}
+
+void FrameCapture::writeFrame(const unsigned char* pixels, int frame, int width, int height) {
+	if (format == PNG)
+		writePNG(pixels, frame, width, height);
+	else
+		writeY4M(pixels, width, height);
+}
+
+// RGB, 8 bits, no filter, the deflate stream is stored blocks only, the tree has no zlib headers to compress it
+void FrameCapture::writePNG(const unsigned char* pixels, int frame, int width, int height) {
+	char name[1024];
+	snprintf(name, sizeof(name), "%s/frame_%06d.png", path.c_str(), frame);
+	FILE* file = fopen(name, "wb");
+	if (file == nullptr) {
+		printf("[capture] can't open %s\n", name);
+		return;
+	}
+
+	const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	fwrite(signature, 1, 8, file);
+
+	encoded.clear();
+	putBigEndian(encoded, width);
+	putBigEndian(encoded, height);
+	const unsigned char header[5] = { 8, 2, 0, 0, 0 };	// bit depth, RGB, deflate, adaptive filters, not interlaced
+	encoded.insert(encoded.end(), header, header + 5);
+	writeChunk(file, "IHDR", encoded.data(), encoded.size());
+
+	// a filter byte and the RGB of a row, GL reads the rows from the bottom
+	size_t rowSize = 1 + (size_t)width * 3;
+	size_t rawSize = rowSize * height;
+	row.resize(rowSize);
+	encoded.clear();
+	encoded.reserve(2 + rawSize + (rawSize / STORED_BLOCK_SIZE + 1) * 5 + 4);
+	encoded.push_back(0x78);	// deflate, 32K window
+	encoded.push_back(0x01);
+	unsigned int a = 1, b = 0;	// Adler-32
+	size_t blockLeft = 0;
+	size_t rawLeft = rawSize;
+	for (int y = height - 1; y >= 0; y--) {
+		const unsigned char* source = pixels + (size_t)y * width * 4;
+		row[0] = 0;
+		for (int x = 0; x < width; x++) {
+			row[1 + x * 3] = source[x * 4];
+			row[2 + x * 3] = source[x * 4 + 1];
+			row[3 + x * 3] = source[x * 4 + 2];
+		}
+		for (size_t i = 0; i < rowSize; i++) {
+			if (blockLeft == 0) {
+				blockLeft = rawLeft < STORED_BLOCK_SIZE ? rawLeft : STORED_BLOCK_SIZE;
+				unsigned short length = (unsigned short)blockLeft;
+				encoded.push_back(rawLeft == blockLeft ? 1 : 0);	// the final block
+				encoded.push_back((unsigned char)length);
+				encoded.push_back((unsigned char)(length >> 8));
+				encoded.push_back((unsigned char)~length);
+				encoded.push_back((unsigned char)(~length >> 8));
+			}
+			encoded.push_back(row[i]);
+			a = (a + row[i]) % 65521;
+			b = (b + a) % 65521;
+			blockLeft--;
+			rawLeft--;
+		}
+	}
+	putBigEndian(encoded, (b << 16) | a);
+	writeChunk(file, "IDAT", encoded.data(), encoded.size());
+	writeChunk(file, "IEND", nullptr, 0);
+	fclose(file);
+}
+
+// 4:4:4 planes of BT.601 studio range YCbCr, a frame of another size than the first is skipped
+void FrameCapture::writeY4M(const unsigned char* pixels, int width, int height) {
+	if (videoWidth == 0) {
+		videoWidth = width;
+		videoHeight = height;
+		fprintf(video, "YUV4MPEG2 W%d H%d F" VIDEO_FRAME_RATE " Ip A1:1 C444\n", width, height);
+	}
+	else if (width != videoWidth || height != videoHeight) {
+		printf("[capture] a frame of %dx%d is skipped, the video is %dx%d\n", width, height, videoWidth, videoHeight);
+		return;
+	}
+
+	fputs("FRAME\n", video);
+	row.resize(width);
+	for (int plane = 0; plane < 3; plane++) {
+		for (int y = height - 1; y >= 0; y--) {
+			const unsigned char* source = pixels + (size_t)y * width * 4;
+			for (int x = 0; x < width; x++) {
+				int r = source[x * 4], g = source[x * 4 + 1], b = source[x * 4 + 2];
+				int value;
+				if (plane == 0)
+					value = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+				else if (plane == 1)
+					value = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+				else
+					value = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+				row[x] = (unsigned char)value;
+			}
+			fwrite(row.data(), 1, width, video);
+		}
+	}
+}
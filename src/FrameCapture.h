@@ -0,0 +1,82 @@
+#pragma once
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// write the frames on the window to disk, for videos and for comparing the images of two builds
+// start it from the command line with --capture <path>, a path ending in .y4m is one raw YUV4MPEG2 video,
+// any other path is a directory for a sequence of PNG files
+// after drawFrame() the back buffer is read into a ring of pixel buffers with a fence each,
+// a buffer is handed to the writer thread only when its fence is signaled, so the draw never waits for the GPU
+// the buffers are mapped once and kept mapped, the writer reads them in place
+// when the writer is behind by the whole ring the draw waits for it, no frame is dropped
+class FrameCapture {
+public:
+	enum Format { PNG, Y4M };
+
+	static FrameCapture& get();
+
+	bool start(const char* path);
+	// the frames still read by the GPU are lost, the ones handed to the writer are written first
+	void stop();
+	bool isCapturing() const { return capturing; }
+
+	// read the default frame buffer of the size of the window, the GL context must be current
+	void captureFrame(int width, int height);
+
+	~FrameCapture();
+
+private:
+	static const int RING_SIZE = 4;
+
+	enum SlotState { FREE, READING, WRITING };
+	struct Slot {
+		unsigned int PBO = 0;
+		unsigned char* pixels = nullptr;	// mapped for the life of the buffer
+		void* fence = nullptr;	// GLsync
+		SlotState state = FREE;
+		int frame = 0;
+	};
+
+	bool capturing = false;
+	Format format = PNG;
+	std::string path;
+	FILE* video = nullptr;	// Y4M
+
+	Slot slots[RING_SIZE];
+	int nextSlot = 0;
+	int width = 0, height = 0;	// of the buffers
+	int frames = 0;
+	bool hasStalled = false;
+
+	// the slots are shared with the writer
+	std::thread writer;
+	std::mutex mutex;
+	std::condition_variable workReady;
+	std::condition_variable slotFreed;
+	std::deque<int> queue;	// slots for the writer, in the order of the frames
+	bool isQuitting = false;
+
+	// the writer thread only
+	std::vector<unsigned char> row;
+	std::vector<unsigned char> encoded;
+	int videoWidth = 0, videoHeight = 0;
+
+	FrameCapture() {}
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture& operator=(const FrameCapture&) = delete;
+
+	bool createBuffers(int width, int height);
+	void releaseBuffers();
+	// hand the slots read by the GPU to the writer, from the oldest, until one isn't done or wait for all
+	void handOff(bool wait);
+
+	void writerLoop();
+	void writeFrame(const unsigned char* pixels, int frame, int width, int height);
+	void writePNG(const unsigned char* pixels, int frame, int width, int height);
+	void writeY4M(const unsigned char* pixels, int width, int height);
+};
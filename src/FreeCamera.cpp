@@ -14,6 +14,7 @@
 #pragma warning(pop)
 
 #include "Utilities/3DUtils.h"
+#include "InputRecorder.h"
 
 FreeCamera::FreeCamera() {
 	this->window = 0;
@@ -90,16 +91,16 @@ int FreeCamera::handle(int e) {
 			if (mode != Mode::None) {
 				glm::vec3 right = glm::cross(direction, up);
 				glm::vec3 moveDir = glm::vec3(0, 0, 0);
-				if (Fl::event_key((int)'w') || Fl::event_key((int)'W')) {
+				if (InputRecorder::get().keyDown('w')) {
 					moveDir += direction;
 				}
-				if (Fl::event_key((int)'a') || Fl::event_key((int)'A')) {
+				if (InputRecorder::get().keyDown('a')) {
 					moveDir -= right;
 				}
-				if (Fl::event_key((int)'s') || Fl::event_key((int)'S')) {
+				if (InputRecorder::get().keyDown('s')) {
 					moveDir -= direction;
 				}
-				if (Fl::event_key((int)'d') || Fl::event_key((int)'D')) {
+				if (InputRecorder::get().keyDown('d')) {
 					moveDir += right;
 				}
 				position += moveDir * Speed;
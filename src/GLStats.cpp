@@ -0,0 +1,280 @@
+#include "GLStats.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <glad/glad.h>
+#include <FL/gl.h>
+
+#define CSV_PATH "gl_stats.csv"
+#define OVERLAY_LINE_HEIGHT 14
+
+namespace {
+	struct Pass {
+		const char* name;
+		long long counts[GLStats::COUNTER_AMOUNT];
+	};
+
+	const char* COUNTER_NAMES[GLStats::COUNTER_AMOUNT] = {
+		"draws", "programs", "redundant", "program0", "vao", "texture", "buffer", "fbo", "upload_bytes", "uniform_lookups", "uniform_sets"
+	};
+
+	bool enabled = false;
+	FILE* csv = nullptr;
+	long long frame = 0;
+	std::vector<Pass> passes;
+	int currentPass = 0;
+	GLuint currentProgram = 0;
+}
+
+//---------------wrappers-----------------
+// each keeps the real function glad loaded and counts before calling it
+
+#define COUNT_WRAPPER(name, PFN, params, args, counter) \
+	static PFN real_##name; \
+	static void APIENTRY count_##name params { GLStats::add(GLStats::counter); real_##name args; }
+
+COUNT_WRAPPER(glDrawArrays, PFNGLDRAWARRAYSPROC, (GLenum mode, GLint first, GLsizei count), (mode, first, count), DRAW_CALLS)
+COUNT_WRAPPER(glDrawElements, PFNGLDRAWELEMENTSPROC, (GLenum mode, GLsizei count, GLenum type, const void* indices), (mode, count, type, indices), DRAW_CALLS)
+COUNT_WRAPPER(glDrawArraysInstanced, PFNGLDRAWARRAYSINSTANCEDPROC, (GLenum mode, GLint first, GLsizei count, GLsizei instances),
+	(mode, first, count, instances), DRAW_CALLS)
+COUNT_WRAPPER(glDrawElementsInstanced, PFNGLDRAWELEMENTSINSTANCEDPROC, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances),
+	(mode, count, type, indices, instances), DRAW_CALLS)
+COUNT_WRAPPER(glDrawElementsInstancedBaseInstance, PFNGLDRAWELEMENTSINSTANCEDBASEINSTANCEPROC, (GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instances, GLuint baseInstance),
+	(mode, count, type, indices, instances, baseInstance), DRAW_CALLS)
+// one call for all the ranges, as the CPU sees it
+COUNT_WRAPPER(glMultiDrawElements, PFNGLMULTIDRAWELEMENTSPROC, (GLenum mode, const GLsizei* count, GLenum type, const void* const* indices, GLsizei drawCount),
+	(mode, count, type, indices, drawCount), DRAW_CALLS)
+COUNT_WRAPPER(glBindVertexArray, PFNGLBINDVERTEXARRAYPROC, (GLuint array), (array), VAO_BINDS)
+COUNT_WRAPPER(glBindTexture, PFNGLBINDTEXTUREPROC, (GLenum target, GLuint texture), (target, texture), TEXTURE_BINDS)
+COUNT_WRAPPER(glBindBuffer, PFNGLBINDBUFFERPROC, (GLenum target, GLuint buffer), (target, buffer), BUFFER_BINDS)
+COUNT_WRAPPER(glBindFramebuffer, PFNGLBINDFRAMEBUFFERPROC, (GLenum target, GLuint framebuffer), (target, framebuffer), FRAMEBUFFER_BINDS)
+COUNT_WRAPPER(glUniform1i, PFNGLUNIFORM1IPROC, (GLint location, GLint v0), (location, v0), UNIFORM_SETS)
+COUNT_WRAPPER(glUniform1f, PFNGLUNIFORM1FPROC, (GLint location, GLfloat v0), (location, v0), UNIFORM_SETS)
+COUNT_WRAPPER(glUniform2f, PFNGLUNIFORM2FPROC, (GLint location, GLfloat v0, GLfloat v1), (location, v0, v1), UNIFORM_SETS)
+COUNT_WRAPPER(glUniform3f, PFNGLUNIFORM3FPROC, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2), (location, v0, v1, v2), UNIFORM_SETS)
+COUNT_WRAPPER(glUniform4f, PFNGLUNIFORM4FPROC, (GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3), (location, v0, v1, v2, v3), UNIFORM_SETS)
+COUNT_WRAPPER(glUniform2fv, PFNGLUNIFORM2FVPROC, (GLint location, GLsizei count, const GLfloat* value), (location, count, value), UNIFORM_SETS)
+COUNT_WRAPPER(glUniform3fv, PFNGLUNIFORM3FVPROC, (GLint location, GLsizei count, const GLfloat* value), (location, count, value), UNIFORM_SETS)
+COUNT_WRAPPER(glUniform4fv, PFNGLUNIFORM4FVPROC, (GLint location, GLsizei count, const GLfloat* value), (location, count, value), UNIFORM_SETS)
+COUNT_WRAPPER(glUniformMatrix2fv, PFNGLUNIFORMMATRIX2FVPROC, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),
+	(location, count, transpose, value), UNIFORM_SETS)
+COUNT_WRAPPER(glUniformMatrix3fv, PFNGLUNIFORMMATRIX3FVPROC, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),
+	(location, count, transpose, value), UNIFORM_SETS)
+COUNT_WRAPPER(glUniformMatrix4fv, PFNGLUNIFORMMATRIX4FVPROC, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),
+	(location, count, transpose, value), UNIFORM_SETS)
+// Shader sets its uniforms without binding the program
+COUNT_WRAPPER(glProgramUniform1i, PFNGLPROGRAMUNIFORM1IPROC, (GLuint program, GLint location, GLint v0), (program, location, v0), UNIFORM_SETS)
+COUNT_WRAPPER(glProgramUniform1f, PFNGLPROGRAMUNIFORM1FPROC, (GLuint program, GLint location, GLfloat v0), (program, location, v0), UNIFORM_SETS)
+COUNT_WRAPPER(glProgramUniform2f, PFNGLPROGRAMUNIFORM2FPROC, (GLuint program, GLint location, GLfloat v0, GLfloat v1), (program, location, v0, v1), UNIFORM_SETS)
+COUNT_WRAPPER(glProgramUniform3f, PFNGLPROGRAMUNIFORM3FPROC, (GLuint program, GLint location, GLfloat v0, GLfloat v1, GLfloat v2), (program, location, v0, v1, v2), UNIFORM_SETS)
+COUNT_WRAPPER(glProgramUniform4f, PFNGLPROGRAMUNIFORM4FPROC, (GLuint program, GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3),
+	(program, location, v0, v1, v2, v3), UNIFORM_SETS)
+COUNT_WRAPPER(glProgramUniform2fv, PFNGLPROGRAMUNIFORM2FVPROC, (GLuint program, GLint location, GLsizei count, const GLfloat* value), (program, location, count, value), UNIFORM_SETS)
+COUNT_WRAPPER(glProgramUniform3fv, PFNGLPROGRAMUNIFORM3FVPROC, (GLuint program, GLint location, GLsizei count, const GLfloat* value), (program, location, count, value), UNIFORM_SETS)
+COUNT_WRAPPER(glProgramUniform4fv, PFNGLPROGRAMUNIFORM4FVPROC, (GLuint program, GLint location, GLsizei count, const GLfloat* value), (program, location, count, value), UNIFORM_SETS)
+COUNT_WRAPPER(glProgramUniformMatrix2fv, PFNGLPROGRAMUNIFORMMATRIX2FVPROC, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),
+	(program, location, count, transpose, value), UNIFORM_SETS)
+COUNT_WRAPPER(glProgramUniformMatrix3fv, PFNGLPROGRAMUNIFORMMATRIX3FVPROC, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),
+	(program, location, count, transpose, value), UNIFORM_SETS)
+COUNT_WRAPPER(glProgramUniformMatrix4fv, PFNGLPROGRAMUNIFORMMATRIX4FVPROC, (GLuint program, GLint location, GLsizei count, GLboolean transpose, const GLfloat* value),
+	(program, location, count, transpose, value), UNIFORM_SETS)
+
+static PFNGLUSEPROGRAMPROC real_glUseProgram;
+static void APIENTRY count_glUseProgram(GLuint program) {
+	if (program == 0)
+		GLStats::add(GLStats::FIXED_FUNCTION);
+	else if (program == currentProgram)
+		GLStats::add(GLStats::PROGRAM_REDUNDANT);
+	else
+		GLStats::add(GLStats::PROGRAM_CHANGES);
+	currentProgram = program;
+	real_glUseProgram(program);
+}
+
+static PFNGLBUFFERDATAPROC real_glBufferData;
+static void APIENTRY count_glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+	GLStats::add(GLStats::UPLOAD_BYTES, size);
+	real_glBufferData(target, size, data, usage);
+}
+
+static PFNGLBUFFERSUBDATAPROC real_glBufferSubData;
+static void APIENTRY count_glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+	GLStats::add(GLStats::UPLOAD_BYTES, size);
+	real_glBufferSubData(target, offset, size, data);
+}
+
+static PFNGLGETUNIFORMLOCATIONPROC real_glGetUniformLocation;
+static GLint APIENTRY count_glGetUniformLocation(GLuint program, const GLchar* name) {
+	GLStats::add(GLStats::UNIFORM_LOOKUPS);
+	return real_glGetUniformLocation(program, name);
+}
+
+#define INSTALL_WRAPPER(name) \
+	if (glad_##name != count_##name) { \
+		real_##name = glad_##name; \
+		glad_##name = count_##name; \
+	}
+
+void GLStats::install() {
+	INSTALL_WRAPPER(glDrawArrays)
+	INSTALL_WRAPPER(glDrawElements)
+	INSTALL_WRAPPER(glDrawArraysInstanced)
+	INSTALL_WRAPPER(glDrawElementsInstanced)
+	INSTALL_WRAPPER(glDrawElementsInstancedBaseInstance)
+	INSTALL_WRAPPER(glMultiDrawElements)
+	INSTALL_WRAPPER(glUseProgram)
+	INSTALL_WRAPPER(glBindVertexArray)
+	INSTALL_WRAPPER(glBindTexture)
+	INSTALL_WRAPPER(glBindBuffer)
+	INSTALL_WRAPPER(glBindFramebuffer)
+	INSTALL_WRAPPER(glBufferData)
+	INSTALL_WRAPPER(glBufferSubData)
+	INSTALL_WRAPPER(glGetUniformLocation)
+	INSTALL_WRAPPER(glUniform1i)
+	INSTALL_WRAPPER(glUniform1f)
+	INSTALL_WRAPPER(glUniform2f)
+	INSTALL_WRAPPER(glUniform3f)
+	INSTALL_WRAPPER(glUniform4f)
+	INSTALL_WRAPPER(glUniform2fv)
+	INSTALL_WRAPPER(glUniform3fv)
+	INSTALL_WRAPPER(glUniform4fv)
+	INSTALL_WRAPPER(glUniformMatrix2fv)
+	INSTALL_WRAPPER(glUniformMatrix3fv)
+	INSTALL_WRAPPER(glUniformMatrix4fv)
+	INSTALL_WRAPPER(glProgramUniform1i)
+	INSTALL_WRAPPER(glProgramUniform1f)
+	INSTALL_WRAPPER(glProgramUniform2f)
+	INSTALL_WRAPPER(glProgramUniform3f)
+	INSTALL_WRAPPER(glProgramUniform4f)
+	INSTALL_WRAPPER(glProgramUniform2fv)
+	INSTALL_WRAPPER(glProgramUniform3fv)
+	INSTALL_WRAPPER(glProgramUniform4fv)
+	INSTALL_WRAPPER(glProgramUniformMatrix2fv)
+	INSTALL_WRAPPER(glProgramUniformMatrix3fv)
+	INSTALL_WRAPPER(glProgramUniformMatrix4fv)
+}
+
+//---------------GLStats-----------------
+
+void GLStats::setEnabled(bool enable) {
+	if (enable == enabled)
+		return;
+	enabled = enable;
+	if (enable) {
+		csv = fopen(CSV_PATH, "w");
+		if (csv != nullptr) {
+			fprintf(csv, "frame,pass");
+			for (int i = 0; i < COUNTER_AMOUNT; i++)
+				fprintf(csv, ",%s", COUNTER_NAMES[i]);
+			fprintf(csv, "\n");
+		}
+		frame = 0;
+	}
+	else if (csv != nullptr) {
+		fclose(csv);
+		csv = nullptr;
+	}
+}
+
+bool GLStats::isEnabled() {
+	return enabled;
+}
+
+void GLStats::beginFrame() {
+	passes.clear();
+	currentPass = 0;
+	if (!enabled)
+		return;
+	install();
+	// the program bound at the end of the last frame is unknown after the wrappers were restored
+	currentProgram = (GLuint)-1;
+	beginPass("frame");
+}
+
+void GLStats::beginPass(const char* name) {
+	if (!enabled)
+		return;
+	for (currentPass = 0; currentPass < (int)passes.size(); currentPass++) {
+		if (strcmp(passes[currentPass].name, name) == 0)
+			return;
+	}
+	Pass pass;
+	pass.name = name;
+	memset(pass.counts, 0, sizeof(pass.counts));
+	passes.push_back(pass);
+}
+
+void GLStats::add(Counter counter, long long amount) {
+	if (currentPass < (int)passes.size())
+		passes[currentPass].counts[counter] += amount;
+}
+
+void GLStats::endFrame() {
+	if (!enabled)
+		return;
+	if (csv != nullptr) {
+		for (const Pass& pass : passes) {
+			fprintf(csv, "%lld,%s", frame, pass.name);
+			for (int i = 0; i < COUNTER_AMOUNT; i++)
+				fprintf(csv, ",%lld", pass.counts[i]);
+			fprintf(csv, "\n");
+		}
+	}
+	frame++;
+}
+
+void GLStats::drawOverlay(int width, int height) {
+	if (!enabled)
+		return;
+	// the counts are taken before the overlay draws anything
+	std::vector<Pass> shown = passes;
+	Pass total = { "total", {} };
+	for (const Pass& pass : shown) {
+		for (int i = 0; i < COUNTER_AMOUNT; i++)
+			total.counts[i] += pass.counts[i];
+	}
+	shown.push_back(total);
+	beginPass("overlay");
+
+	// fixed function on the window
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glUseProgram(0);
+	glViewport(0, 0, width, height);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_LIGHTING);
+	glDisable(GL_TEXTURE_2D);
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glOrtho(0, width, 0, height, -1, 1);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	int lines = (int)shown.size() + 1;
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glColor4f(0, 0, 0, 0.6f);
+	glRectf(0, (float)(height - lines * OVERLAY_LINE_HEIGHT - 6), 640, (float)height);
+	glDisable(GL_BLEND);
+
+	gl_font(FL_COURIER, 12);
+	gl_color(FL_WHITE);
+	int y = height - OVERLAY_LINE_HEIGHT;
+	gl_draw("pass          draws  progs redund prog0   vaos   texs  bufs  fbos upload KB lookup uniform", 4, y);
+	char line[256];
+	for (const Pass& pass : shown) {
+		y -= OVERLAY_LINE_HEIGHT;
+		const long long* c = pass.counts;
+		snprintf(line, sizeof(line), "%-12.12s %6lld %6lld %6lld %5lld %6lld %6lld %5lld %5lld %9.1f %6lld %7lld",
+			pass.name, c[DRAW_CALLS], c[PROGRAM_CHANGES], c[PROGRAM_REDUNDANT], c[FIXED_FUNCTION], c[VAO_BINDS], c[TEXTURE_BINDS],
+			c[BUFFER_BINDS], c[FRAMEBUFFER_BINDS], c[UPLOAD_BYTES] / 1024.0, c[UNIFORM_LOOKUPS], c[UNIFORM_SETS]);
+		gl_draw(line, 4, y);
+	}
+
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+	glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+// count the GL calls and state changes of a frame, for every pass of it
+// while enabled the glad function pointers are swapped with counting wrappers, so every caller
+// (Shader, InstanceDrawer, Mesh, TrainView...) is counted without being changed
+// gladLoadGL() restores the real pointers, so beginFrame() swaps them again after it
+// the counts of the last frame are drawn over the view, and a row for every pass is written to gl_stats.csv
+class GLStats {
+public:
+	enum Counter {
+		DRAW_CALLS,
+		PROGRAM_CHANGES,	// glUseProgram of another program
+		PROGRAM_REDUNDANT,	// glUseProgram of the bound program
+		FIXED_FUNCTION,	// glUseProgram(0)
+		VAO_BINDS,
+		TEXTURE_BINDS,
+		BUFFER_BINDS,
+		FRAMEBUFFER_BINDS,
+		UPLOAD_BYTES,	// glBufferData and glBufferSubData
+		UNIFORM_LOOKUPS,	// glGetUniformLocation
+		UNIFORM_SETS,
+		COUNTER_AMOUNT
+	};
+
+	static void setEnabled(bool enable);
+	static bool isEnabled();
+
+	// call after gladLoadGL(), the counts start in the pass "frame"
+	static void beginFrame();
+	// name must live until the end of the frame, e.g. a string literal
+	static void beginPass(const char* name);
+	static void endFrame();
+	// the counts of this frame so far, on the default frame buffer
+	static void drawOverlay(int width, int height);
+
+	static void add(Counter counter, long long amount = 1);
+
+private:
+	static void install();
+};
@@ -0,0 +1,265 @@
+#include "InputRecorder.h"
+#include <cctype>
+#include <cstring>
+#include <ctime>
+
+#pragma warning(push)
+#pragma warning(disable:4312)
+#pragma warning(disable:4311)
+#include <Fl/Fl.h>
+#include <Fl/Fl_Button.h>
+#include <Fl/Fl_Valuator.H>
+#include <Fl/Fl_Browser.H>
+#pragma warning(pop)
+
+#include "TrainWindow.H"
+#include "TrainView.H"
+#include "Random.h"
+
+// keys polled by Fl::event_key() in a handler, one bit each in the log
+#define TRACKED_KEYS "wasd"
+
+InputRecorder& InputRecorder::get() {
+	static InputRecorder recorder;
+	return recorder;
+}
+
+InputRecorder::~InputRecorder() {
+	stop();
+}
+
+InputRecorder::Mode InputRecorder::getMode() const {
+	return mode;
+}
+
+bool InputRecorder::startRecording(const char* path, TrainWindow* tw) {
+	stop();
+	file = fopen(path, "w");
+	if (file == nullptr) {
+		printf("[record] can't open %s\n", path);
+		return false;
+	}
+	this->tw = tw;
+	mode = RECORDING;
+	frames = 0;
+
+	uint64_t seed = (uint64_t)time(0);
+	Random::setSeed(seed);
+	fprintf(file, "seed %llu\n", (unsigned long long)seed);
+	fprintf(file, "size %d %d\n", tw->trainView->w(), tw->trainView->h());
+
+	// every callback of the control panel goes through widgetCB() to be logged
+	collectWidgets();
+	for (size_t i = 0; i < widgets.size(); i++)
+		widgets[i].widget->callback(widgetCB, (void*)i);
+	printf("[record] recording to %s\n", path);
+	return true;
+}
+
+bool InputRecorder::startReplay(const char* path, TrainWindow* tw) {
+	stop();
+	FILE* in = fopen(path, "r");
+	if (in == nullptr) {
+		printf("[replay] can't open %s\n", path);
+		return false;
+	}
+	unsigned long long seed = 0;
+	int width = 0, height = 0;
+	if (fscanf(in, " seed %llu size %d %d", &seed, &width, &height) != 3) {
+		printf("[replay] %s is not a recording\n", path);
+		fclose(in);
+		return false;
+	}
+	entries.clear();
+	char type;
+	while (fscanf(in, " %c", &type) == 1) {
+		Entry entry = {};
+		entry.type = type;
+		if (type == 'E') {
+			fscanf(in, "%d %d %d %d %d %d %d %d %d %d %d %d", &entry.event, &entry.x, &entry.y, &entry.xRoot, &entry.yRoot,
+				&entry.dx, &entry.dy, &entry.state, &entry.clicks, &entry.isClick, &entry.keysym, &entry.keys);
+		}
+		else if (type == 'W') {
+			fscanf(in, "%d %lf", &entry.widget, &entry.value);
+		}
+		entries.push_back(entry);
+	}
+	fclose(in);
+
+	if (width != tw->trainView->w() || height != tw->trainView->h())
+		printf("[replay] recorded with a %dx%d view, the mouse positions will be off\n", width, height);
+	this->tw = tw;
+	mode = REPLAYING;
+	next = 0;
+	frames = 0;
+	Random::setSeed(seed);
+	collectWidgets();
+	printf("[replay] %s, %d entries\n", path, (int)entries.size());
+	return true;
+}
+
+void InputRecorder::stop() {
+	if (mode == RECORDING) {
+		for (auto& w : widgets)
+			w.widget->callback(w.callback, w.userData);
+		fclose(file);
+		file = nullptr;
+		printf("[record] %d frames recorded\n", frames);
+	}
+	mode = OFF;
+	widgets.clear();
+	entries.clear();
+}
+
+bool InputRecorder::onEvent(int event) {
+	if (!isInputEvent(event))
+		return true;
+	if (mode == REPLAYING)
+		return feeding;
+	if (mode == RECORDING) {
+		fprintf(file, "E %d %d %d %d %d %d %d %d %d %d %d %d\n", event, Fl::e_x, Fl::e_y, Fl::e_x_root, Fl::e_y_root,
+			Fl::e_dx, Fl::e_dy, Fl::e_state, Fl::e_clicks, Fl::e_is_click, Fl::e_keysym, trackedKeys());
+	}
+	return true;
+}
+
+void InputRecorder::onTick() {
+	if (mode == RECORDING)
+		fprintf(file, "T\n");
+}
+
+void InputRecorder::onDraw() {
+	if (mode == RECORDING) {
+		fprintf(file, "D\n");
+		frames++;
+	}
+	else if (mode == REPLAYING) {
+		if (frames == 0)
+			startTime = std::chrono::steady_clock::now();
+		while (next < entries.size()) {
+			const Entry& entry = entries[next++];
+			if (entry.type == 'D') {
+				frames++;
+				return;
+			}
+			playEntry(entry);
+		}
+		finishReplay();
+	}
+}
+
+bool InputRecorder::keyDown(int key) {
+	key = tolower(key);
+	if (feeding) {
+		const char* tracked = strchr(TRACKED_KEYS, key);
+		return tracked != nullptr && (feedingKeys & (1 << (tracked - TRACKED_KEYS)));
+	}
+	return Fl::event_key(key) || Fl::event_key(toupper(key));
+}
+
+// breadth first, so the widgets of the panel itself keep the indices they had before the nested groups were walked
+void InputRecorder::collectWidgets() {
+	widgets.clear();
+	std::vector<Fl_Group*> groups(1, tw->widgets);
+	for (size_t g = 0; g < groups.size(); g++) {
+		for (int i = 0; i < groups[g]->children(); i++) {
+			Fl_Widget* widget = groups[g]->child(i);
+			widgets.push_back(Widget{ widget, widget->callback(), widget->user_data() });
+			// the camera radio buttons are in a group of their own, the scrollbars of a browser are its own business
+			Fl_Group* group = widget->as_group();
+			if (group != nullptr && dynamic_cast<Fl_Browser*>(widget) == nullptr)
+				groups.push_back(group);
+		}
+	}
+}
+
+void InputRecorder::playEntry(const Entry& entry) {
+	switch (entry.type) {
+	case 'E':
+		Fl::e_x = entry.x;
+		Fl::e_y = entry.y;
+		Fl::e_x_root = entry.xRoot;
+		Fl::e_y_root = entry.yRoot;
+		Fl::e_dx = entry.dx;
+		Fl::e_dy = entry.dy;
+		Fl::e_state = entry.state;
+		Fl::e_clicks = entry.clicks;
+		Fl::e_is_click = entry.isClick;
+		Fl::e_keysym = entry.keysym;
+		feeding = true;
+		feedingKeys = entry.keys;
+		tw->trainView->handle(entry.event);
+		feeding = false;
+		break;
+	case 'W':
+		if (entry.widget >= 0 && entry.widget < (int)widgets.size()) {
+			setWidgetValue(widgets[entry.widget].widget, entry.value);
+			widgets[entry.widget].widget->do_callback();
+		}
+		break;
+	case 'T':
+		tw->advanceTrain();
+		break;
+	}
+}
+
+void InputRecorder::finishReplay() {
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	printf("[replay] done, %d frames in %.2fs, %.3f ms per frame\n", frames, seconds, frames > 0 ? seconds * 1000 / frames : 0.0);
+	stop();
+}
+
+bool InputRecorder::isInputEvent(int event) {
+	switch (event) {
+	case FL_PUSH:
+	case FL_RELEASE:
+	case FL_DRAG:
+	case FL_MOVE:
+	case FL_MOUSEWHEEL:
+	case FL_KEYBOARD:
+	case FL_KEYUP:
+		return true;
+	}
+	return false;
+}
+
+int InputRecorder::trackedKeys() {
+	int keys = 0;
+	for (int i = 0; TRACKED_KEYS[i]; i++) {
+		if (Fl::event_key(TRACKED_KEYS[i]) || Fl::event_key(toupper(TRACKED_KEYS[i])))
+			keys |= 1 << i;
+	}
+	return keys;
+}
+
+double InputRecorder::getWidgetValue(Fl_Widget* widget) {
+	if (Fl_Valuator* valuator = dynamic_cast<Fl_Valuator*>(widget))
+		return valuator->value();
+	if (Fl_Browser* browser = dynamic_cast<Fl_Browser*>(widget))
+		return browser->value();
+	if (Fl_Button* button = dynamic_cast<Fl_Button*>(widget))
+		return button->value();
+	return 0;
+}
+
+void InputRecorder::setWidgetValue(Fl_Widget* widget, double value) {
+	if (Fl_Valuator* valuator = dynamic_cast<Fl_Valuator*>(widget))
+		valuator->value(value);
+	else if (Fl_Browser* browser = dynamic_cast<Fl_Browser*>(widget))
+		browser->value((int)value);
+	else if (Fl_Button* button = dynamic_cast<Fl_Button*>(widget)) {
+		// a radio button turns the others of its group off
+		if (button->type() == FL_RADIO_BUTTON && value != 0)
+			button->setonly();
+		else
+			button->value((int)value);
+	}
+}
+
+void InputRecorder::widgetCB(Fl_Widget* widget, void* index) {
+	InputRecorder& recorder = get();
+	Widget& w = recorder.widgets[(size_t)index];
+	if (recorder.mode == RECORDING)
+		fprintf(recorder.file, "W %d %.17g\n", (int)(size_t)index, getWidgetValue(widget));
+	w.callback(widget, w.userData);
+}
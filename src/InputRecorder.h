@@ -0,0 +1,82 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+class TrainWindow;
+class Fl_Widget;
+
+// record the input of a run and feed it back, so two builds can be measured on the same workload
+// start it from the command line with --record <file> or --replay <file>
+// the log keeps everything in the order it happened:
+//   the seed of the random streams and the size of the view
+//   E: an input event of TrainView::handle() with the FLTK event state
+//   W: a callback of a control panel widget with the value of the widget
+//   T: a tick of TrainWindow::advanceTrain()
+//   D: a TrainView::draw()
+// while recording or replaying the animation use a fixed time step
+// a replay feeds the entries up to the next D at the start of every draw, redraws as fast as it can
+// and drops the live input of the view, the key state of the free camera is replayed too
+class InputRecorder {
+public:
+	enum Mode { OFF, RECORDING, REPLAYING };
+
+	static InputRecorder& get();
+
+	bool startRecording(const char* path, TrainWindow* tw);
+	bool startReplay(const char* path, TrainWindow* tw);
+	void stop();
+
+	Mode getMode() const;
+
+	// false if the event is live input which must be dropped during a replay
+	bool onEvent(int event);
+	void onTick();
+	void onDraw();
+	// is the key down for the event being handled, key in lower case
+	bool keyDown(int key);
+
+	~InputRecorder();
+
+private:
+	struct Entry {
+		char type;
+		// E
+		int event, x, y, xRoot, yRoot, dx, dy, state, clicks, isClick, keysym, keys;
+		// W
+		int widget;
+		double value;
+	};
+	// widgets of the control panel, their callbacks are wrapped while recording
+	struct Widget {
+		Fl_Widget* widget;
+		void (*callback)(Fl_Widget*, void*);
+		void* userData;
+	};
+
+	Mode mode = OFF;
+	TrainWindow* tw = nullptr;
+	FILE* file = nullptr;	// recording
+	std::vector<Entry> entries;	// replay
+	size_t next = 0;
+	std::vector<Widget> widgets;
+	bool feeding = false;	// handling a replayed event
+	int feedingKeys = 0;
+	int frames = 0;
+	std::chrono::steady_clock::time_point startTime;
+
+	InputRecorder() {}
+	InputRecorder(const InputRecorder&) = delete;
+	InputRecorder& operator=(const InputRecorder&) = delete;
+
+	void collectWidgets();
+	void playEntry(const Entry& entry);
+	void finishReplay();
+
+	static bool isInputEvent(int event);
+	static int trackedKeys();
+	static double getWidgetValue(Fl_Widget* widget);
+	static void setWidgetValue(Fl_Widget* widget, double value);
+	static void widgetCB(Fl_Widget* widget, void* index);
+};
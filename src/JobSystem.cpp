@@ -0,0 +1,128 @@
+#include "JobSystem.h"
+
+static thread_local int currentThreadIndex = 0;
+
+//---------------Group-----------------
+
+JobSystem::Group::Group() {
+	pending = 0;
+}
+
+JobSystem::Group::~Group() {
+	wait();
+}
+
+void JobSystem::Group::run(Job job) {
+	pending++;
+	Task task{ std::move(job), this, ALLOC_OTHER };
+#ifdef TRACK_ALLOCATIONS
+	task.allocTag = AllocTracker::currentTag();
+#endif
+	JobSystem::get().push(std::move(task));
+}
+
+// help with any job until all jobs of this group are done
+void JobSystem::Group::wait() {
+	JobSystem& jobSystem = JobSystem::get();
+	while (pending > 0) {
+		if (!jobSystem.runOne())
+			std::this_thread::yield();
+	}
+}
+
+//---------------Job System-----------------
+
+JobSystem& JobSystem::get() {
+	static JobSystem jobSystem;
+	return jobSystem;
+}
+
+int JobSystem::threadIndex() {
+	return currentThreadIndex;
+}
+
+JobSystem::JobSystem() {
+	queued = 0;
+	quit = false;
+	int workerAmount = (int)std::thread::hardware_concurrency() - 1;
+	if (workerAmount < 0)
+		workerAmount = 0;
+	for (int i = 0; i <= workerAmount; i++)
+		queues.push_back(std::unique_ptr<Queue>(new Queue()));
+	for (int i = 1; i <= workerAmount; i++)
+		workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (auto& worker : workers)
+		worker.join();
+}
+
+int JobSystem::getThreadAmount() const {
+	return (int)queues.size();
+}
+
+void JobSystem::push(Task task) {
+	Queue& queue = *queues[currentThreadIndex];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		queued++;
+	}
+	wake.notify_one();
+}
+
+// run the newest job of this thread, or steal the oldest one of another thread
+bool JobSystem::runOne() {
+	Task task;
+	bool found = false;
+	int self = currentThreadIndex;
+	{
+		Queue& queue = *queues[self];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			found = true;
+		}
+	}
+	for (int i = 1; !found && i < (int)queues.size(); i++) {
+		Queue& queue = *queues[(self + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.tasks.empty()) {
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			found = true;
+		}
+	}
+	if (!found)
+		return false;
+
+	queued--;
+	{
+		ALLOC_SCOPE(task.allocTag);
+		task.job();
+	}
+	task.group->pending--;
+	return true;
+}
+
+void JobSystem::workerLoop(int index) {
+	currentThreadIndex = index;
+	while (true) {
+		if (runOne())
+			continue;
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wake.wait(lock, [this]() { return quit || queued > 0; });
+		if (quit)
+			return;
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "AllocTracker.h"
+#include "FrameArena.h"
+
+// a small work-stealing scheduler for the per-frame CPU work
+// every worker owns a queue, it takes its newest job first and steals the oldest job of the others
+// a thread which is waiting for its jobs run jobs too, so jobs can fork more jobs
+class JobSystem {
+public:
+	typedef std::function<void()> Job;
+
+	// fork-join, run() jobs and wait() until all of them are done
+	class Group {
+	public:
+		Group();
+		~Group();
+		void run(Job job);
+		void wait();
+
+	private:
+		friend class JobSystem;
+		std::atomic<int> pending;
+	};
+
+	static JobSystem& get();
+	// index of the calling thread, 0 for the FLTK thread and 1.. for the workers
+	static int threadIndex();
+
+	// workers + the FLTK thread
+	int getThreadAmount() const;
+
+	// run body(first, last) over [begin, end) cut into pieces of grain
+	template <class F>
+	void parallelFor(int begin, int end, int grain, const F& body);
+
+	~JobSystem();
+
+private:
+	struct Task {
+		Job job;
+		Group* group;
+		AllocTag allocTag;	// jobs count their allocations for the tag of the thread which made them
+	};
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues;	// one for every thread index
+	std::vector<std::thread> workers;
+	std::mutex sleepMutex;
+	std::condition_variable wake;
+	std::atomic<int> queued;
+	std::atomic<bool> quit;
+
+	JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	void push(Task task);
+	bool runOne();
+	void workerLoop(int index);
+};
+
+// one T for every thread, a job writes to local() and the owner reads all of them after the join
+// the slots are on the frame arena, so it only live in one frame
+template <class T>
+class PerThread {
+public:
+	PerThread() : slots(JobSystem::get().getThreadAmount()) {}
+
+	T& local() { return slots[JobSystem::threadIndex()].value; }
+
+	int size() const { return (int)slots.size(); }
+	T& operator[](int i) { return slots[i].value; }
+
+private:
+	// keep the slots on their own cache lines
+	struct Slot {
+		T value;
+		char padding[64];
+	};
+	ArenaVector<Slot> slots;
+};
+
+template <class F>
+void JobSystem::parallelFor(int begin, int end, int grain, const F& body) {
+	if (end <= begin)
+		return;
+	if (grain < 1)
+		grain = 1;
+	if (end - begin <= grain || workers.empty()) {
+		body(begin, end);
+		return;
+	}
+	Group group;
+	int first = begin;
+	for (; first + grain < end; first += grain) {
+		int last = first + grain;
+		group.run([&body, first, last]() { body(first, last); });
+	}
+	// the last piece on this thread
+	body(first, end);
+	group.wait();
+}
@@ -1,4 +1,5 @@
 #include "MathHelper.h"
+#include "Random.h"
 
 #define PI 3.14159265
 
@@ -175,41 +176,12 @@ namespace MathHelper {
 
 	//return random float, range [0, 1)
 	float randomFloat() {
-		return (float)rand() / (RAND_MAX + 1.0);
+		return Random::local().nextFloat();
 	}
 
 	// Hͦy@ΤWVVq
 	glm::vec3 randomDirectionInCone(const glm::vec3& direction, float angleDegrees) {
-		// TOVVqVq
-		glm::vec3 normalizedDirection = glm::normalize(direction);
-
-		// Nഫ
-		float angleRadians = glm::radians(angleDegrees);
-
-		// HͦyаѼ
-		float phi = lerp(0, 2 * PI, randomFloat()); //[0, 2*pi]
-		float cosTheta = lerp(std::cos(angleRadians), 1, randomFloat()); //[cos(andgleDegress), 1]
-		float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
-
-		// lͦVq]Hzbߡ^
-		glm::vec3 randomVector(
-			sinTheta * std::cos(phi),
-			sinTheta * std::sin(phi),
-			cosTheta
-		);
-
-		// px}Nzbdirection
-		glm::vec3 up = glm::vec3(0.0f, 0.0f, 1.0f);
-		if (glm::length(glm::cross(up, normalizedDirection)) < 1e-6f) {
-			up = glm::vec3(1.0f, 0.0f, 0.0f); // SpBz
-		}
-		glm::vec3 axis = glm::normalize(glm::cross(up, normalizedDirection));
-		float angleToRotate = std::acos(glm::dot(up, normalizedDirection));
-		glm::mat4 rotationMatrix = glm::rotate(glm::mat4(1.0f), angleToRotate, axis);
-
-		// ഫlVq@ΤV
-		glm::vec4 rotatedVector = rotationMatrix * glm::vec4(randomVector, 0.0f);
-
-		return glm::vec3(rotatedVector);
+		// a generator sampling many directions around the same axis should keep a ConeSampler
+		return ConeSampler(direction, angleDegrees).sample(Random::local());
 	}
 }
\ No newline at end of file
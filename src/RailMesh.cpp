@@ -0,0 +1,162 @@
+#include "RailMesh.h"
+#include <algorithm>
+#include <glad/glad.h>
+
+// corners of the cross section counterclockwise in (right, up), every face has its own two vertices
+#define RAIL_FACE_AMOUNT 4
+#define RAIL_RING_VERTICES (RAIL_FACE_AMOUNT * 2)
+
+const float RailMesh::RAIL_SIZE = 0.3f;
+
+RailMesh::RailMesh() {
+}
+
+RailMesh::~RailMesh() {
+	clear();
+}
+
+void RailMesh::build(const std::vector<TrackSample>& samples, float chunkLength) {
+	chunkFirstIndex.clear();
+	if (samples.size() < 2 || chunkLength <= 0) {
+		if (mesh.VAO != 0)
+			mesh.element_amount = 0;
+		return;
+	}
+
+	const float h = RAIL_SIZE / 2;
+	const glm::vec2 corner[RAIL_FACE_AMOUNT] = {
+		glm::vec2(h, -h), glm::vec2(h, h), glm::vec2(-h, h), glm::vec2(-h, -h)
+	};
+	const glm::vec2 faceNormal[RAIL_FACE_AMOUNT] = {
+		glm::vec2(1, 0), glm::vec2(0, 1), glm::vec2(-1, 0), glm::vec2(0, -1)
+	};
+
+	// a ring of vertices for every sample on every rail
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	positions.reserve(samples.size() * 2 * RAIL_RING_VERTICES);
+	normals.reserve(samples.size() * 2 * RAIL_RING_VERTICES);
+	for (size_t i = 0; i < samples.size(); i++) {
+		const TrackSample& s = samples[i];
+		for (int side = -1; side <= 1; side += 2) {
+			glm::vec3 center = s.pos + s.right * (side * TrackTessellator::RAIL_OFFSET);
+			for (int f = 0; f < RAIL_FACE_AMOUNT; f++) {
+				glm::vec3 normal = s.right * faceNormal[f].x + s.up * faceNormal[f].y;
+				for (int k = 0; k < 2; k++) {
+					const glm::vec2& c = corner[(f + k) % RAIL_FACE_AMOUNT];
+					positions.push_back(center + s.right * c.x + s.up * c.y);
+					normals.push_back(normal);
+				}
+			}
+		}
+	}
+
+	// two triangles for every face of every piece, the piece belongs to the chunk where it starts
+	size_t chunkAmount = (size_t)(samples.back().arcLength / chunkLength) + 1;
+	std::vector<unsigned int> elements;
+	elements.reserve((samples.size() - 1) * 2 * RAIL_FACE_AMOUNT * 6);
+	for (size_t i = 1; i < samples.size(); i++) {
+		size_t chunk = std::min((size_t)(samples[i - 1].arcLength / chunkLength), chunkAmount - 1);
+		while (chunkFirstIndex.size() <= chunk)
+			chunkFirstIndex.push_back((unsigned int)elements.size());
+		for (int rail = 0; rail < 2; rail++) {
+			unsigned int ring0 = (unsigned int)(((i - 1) * 2 + rail) * RAIL_RING_VERTICES);
+			unsigned int ring1 = (unsigned int)((i * 2 + rail) * RAIL_RING_VERTICES);
+			for (int f = 0; f < RAIL_FACE_AMOUNT; f++) {
+				unsigned int a0 = ring0 + f * 2, b0 = a0 + 1;
+				unsigned int a1 = ring1 + f * 2, b1 = a1 + 1;
+				elements.insert(elements.end(), { a0, b1, b0, a0, a1, b1 });
+			}
+		}
+	}
+	while (chunkFirstIndex.size() <= chunkAmount)
+		chunkFirstIndex.push_back((unsigned int)elements.size());
+
+	if (mesh.VAO == 0) {
+		glGenVertexArrays(1, &mesh.VAO);
+		glGenBuffers(2, mesh.VBO);
+		glGenBuffers(1, &mesh.EBO);
+	}
+	glBindVertexArray(mesh.VAO);
+	mesh.element_amount = (unsigned int)elements.size();
+	// Position attribute
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO[0]);
+	glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)0);
+	glEnableVertexAttribArray(0);
+	// Normal attribute
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO[1]);
+	glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), normals.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (GLvoid*)0);
+	glEnableVertexAttribArray(1);
+	//Element attribute
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, elements.size() * sizeof(unsigned int), elements.data(), GL_STATIC_DRAW);
+	// Unbind VAO
+	glBindVertexArray(0);
+}
+
+void RailMesh::draw(Shader* shader, const Material& material, const std::vector<bool>& chunkVisible, unsigned int textureId) {
+	if (mesh.VAO == 0 || mesh.element_amount == 0)
+		return;
+
+	// neighbouring visible chunks are merged into one range
+	drawCounts.clear();
+	drawOffsets.clear();
+	unsigned int rangeEnd = 0;
+	for (size_t i = 0; i + 1 < chunkFirstIndex.size(); i++) {
+		if (i < chunkVisible.size() && !chunkVisible[i])
+			continue;
+		unsigned int first = chunkFirstIndex[i];
+		unsigned int count = chunkFirstIndex[i + 1] - first;
+		if (count == 0)
+			continue;
+		if (!drawCounts.empty() && rangeEnd == first)
+			drawCounts.back() += count;
+		else {
+			drawCounts.push_back(count);
+			drawOffsets.push_back((const void*)(first * sizeof(unsigned int)));
+		}
+		rangeEnd = first + count;
+	}
+	if (drawCounts.empty())
+		return;
+
+	glBindVertexArray(mesh.VAO);
+	shader = shader->variant(textureId != (unsigned int)-1 ? SHADER_USE_IMAGE : 0);
+	shader->use();
+
+	// material properties
+	shader->setVec3("material.ambient", material.ambient);
+	shader->setVec3("material.diffuse", material.diffuse);
+	shader->setVec3("material.specular", material.specular);
+	shader->setFloat("material.shininess", material.shininess);
+
+	// set texture
+	if (textureId != (unsigned int)-1) {
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, textureId);
+		shader->setInt("imageTexture", 0);
+	}
+
+	// the instance shaders read model and normal matrix per instance,
+	// the mesh is in world space so they are constant identity attributes here
+	for (int j = 0; j < 4; j++) {
+		glm::vec4 column(0.0f);
+		column[j] = 1.0f;
+		glVertexAttrib4fv(3 + j, &column[0]);
+		glVertexAttrib4fv(7 + j, &column[0]);
+	}
+
+	glMultiDrawElements(GL_TRIANGLES, drawCounts.data(), GL_UNSIGNED_INT, drawOffsets.data(), (GLsizei)drawCounts.size());
+}
+
+void RailMesh::clear() {
+	if (mesh.VAO != 0) {
+		glDeleteVertexArrays(1, &mesh.VAO);
+		glDeleteBuffers(2, mesh.VBO);
+		glDeleteBuffers(1, &mesh.EBO);
+	}
+	mesh = {};
+	chunkFirstIndex.clear();
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "RenderUnit/RenderStructure.h"
+#include "RenderUnit/Shader.h"
+#include "TrackTessellator.h"
+
+// both rails swept along the tessellated track as one static mesh
+// neighbouring pieces share the vertices of the sample between them
+// the pieces are stored in arc length order, so a culling chunk is a range of the index buffer
+class RailMesh {
+public:
+	static const float RAIL_SIZE;	// width and height of the rail cross section
+
+	RailMesh();
+	~RailMesh();
+
+	// rebuild the buffers, chunkLength is the arc length of a culling chunk
+	void build(const std::vector<TrackSample>& samples, float chunkLength);
+	// draw the visible chunks (all if chunkVisible is empty) by one call, the state is left bound
+	void draw(Shader* shader, const Material& material, const std::vector<bool>& chunkVisible, unsigned int textureId = -1);
+	void clear();
+
+private:
+	Object mesh = {};
+	std::vector<unsigned int> chunkFirstIndex;	// first index of every chunk, and the end of the last one
+
+	// ranges of visible chunks, reused every frame
+	std::vector<GLsizei> drawCounts;
+	std::vector<const void*> drawOffsets;
+};
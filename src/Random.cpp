@@ -0,0 +1,164 @@
+#include "Random.h"
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <memory>
+#include <vector>
+#include "JobSystem.h"
+
+#define TWO_PI 6.28318530718f
+
+static uint32_t rotl(uint32_t x, int k) {
+	return (x << k) | (x >> (32 - k));
+}
+
+// expand a 64 bit seed into the state, so similar seeds give unrelated states
+static uint64_t splitMix64(uint64_t& x) {
+	uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+//---------------Random-----------------
+
+Random::Random() {
+	seed(0);
+}
+
+Random::Random(uint64_t seed) {
+	this->seed(seed);
+}
+
+void Random::seed(uint64_t seed) {
+	uint64_t a = splitMix64(seed), b = splitMix64(seed);
+	s[0] = (uint32_t)a;
+	s[1] = (uint32_t)(a >> 32);
+	s[2] = (uint32_t)b;
+	s[3] = (uint32_t)(b >> 32);
+}
+
+void Random::jump() {
+	static const uint32_t JUMP[] = { 0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b };
+	uint32_t t[4] = { 0, 0, 0, 0 };
+	for (int i = 0; i < 4; i++) {
+		for (int b = 0; b < 32; b++) {
+			if (JUMP[i] & (1u << b)) {
+				t[0] ^= s[0];
+				t[1] ^= s[1];
+				t[2] ^= s[2];
+				t[3] ^= s[3];
+			}
+			next();
+		}
+	}
+	for (int i = 0; i < 4; i++)
+		s[i] = t[i];
+}
+
+uint32_t Random::next() {
+	uint32_t result = rotl(s[1] * 5, 7) * 9;
+	uint32_t t = s[1] << 9;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl(s[3], 11);
+	return result;
+}
+
+uint64_t Random::next64() {
+	uint64_t high = next();
+	return (high << 32) | next();
+}
+
+float Random::nextFloat() {
+	// the high 24 bits fill the mantissa exactly
+	return (next() >> 8) * (1.0f / 16777216.0f);
+}
+
+float Random::nextFloat(float min, float max) {
+	return min + (max - min) * nextFloat();
+}
+
+int Random::nextInt(int min, int max) {
+	if (max <= min)
+		return min;
+	return min + (int)(((uint64_t)next() * (uint32_t)(max - min)) >> 32);
+}
+
+glm::vec3 Random::nextUnitVector() {
+	float z = nextFloat() * 2 - 1;
+	float phi = nextFloat() * TWO_PI;
+	float r = std::sqrt(1 - z * z);
+	return glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
+}
+
+void Random::fillFloats(float* out, int count, float min, float max) {
+	float scale = (max - min) * (1.0f / 16777216.0f);
+	for (int i = 0; i < count; i++)
+		out[i] = min + (next() >> 8) * scale;
+}
+
+void Random::fillUnitVectors(glm::vec3* out, int count) {
+	for (int i = 0; i < count; i++)
+		out[i] = nextUnitVector();
+}
+
+// one stream for every thread index of the job system
+static std::vector<std::unique_ptr<Random>> makeStreams(uint64_t seed) {
+	std::vector<std::unique_ptr<Random>> streams;
+	Random stream(seed);
+	for (int i = 0; i < JobSystem::get().getThreadAmount(); i++) {
+		streams.push_back(std::unique_ptr<Random>(new Random(stream)));
+		stream.jump();
+	}
+	return streams;
+}
+
+static std::vector<std::unique_ptr<Random>>& allStreams() {
+	static std::vector<std::unique_ptr<Random>> streams = makeStreams((uint64_t)time(0));
+	return streams;
+}
+
+Random& Random::local() {
+	return *allStreams()[JobSystem::threadIndex()];
+}
+
+void Random::setSeed(uint64_t seed) {
+	std::vector<std::unique_ptr<Random>> streams = makeStreams(seed);
+	for (size_t i = 0; i < streams.size(); i++)
+		*allStreams()[i] = *streams[i];
+}
+
+//---------------Cone Sampler-----------------
+
+ConeSampler::ConeSampler() {
+	set(glm::vec3(0, 1, 0), 180);
+}
+
+ConeSampler::ConeSampler(glm::vec3 direction, float angleDegrees) {
+	set(direction, angleDegrees);
+}
+
+void ConeSampler::set(glm::vec3 direction, float angleDegrees) {
+	axis = glm::normalize(direction);
+	glm::vec3 helper = std::abs(axis.z) < 0.999f ? glm::vec3(0, 0, 1) : glm::vec3(1, 0, 0);
+	tangent = glm::normalize(glm::cross(helper, axis));
+	bitangent = glm::cross(axis, tangent);
+	cosAngle = std::cos(glm::radians(angleDegrees));
+}
+
+glm::vec3 ConeSampler::sample(Random& random) const {
+	// uniform in the solid angle: cos(theta) is uniform in [cos(angle), 1]
+	float cosTheta = cosAngle + (1 - cosAngle) * random.nextFloat();
+	float sinTheta = std::sqrt(std::max(0.0f, 1 - cosTheta * cosTheta));
+	float phi = random.nextFloat() * TWO_PI;
+	return tangent * (sinTheta * std::cos(phi)) + bitangent * (sinTheta * std::sin(phi)) + axis * cosTheta;
+}
+
+void ConeSampler::fill(Random& random, glm::vec3* out, int count) const {
+	for (int i = 0; i < count; i++)
+		out[i] = sample(random);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// xoshiro128** generator, small and fast, and the same sequence for the same seed on every platform
+// every thread of the job system has its own stream, so nothing is shared between jobs
+// something which must not depend on the thread running it (e.g. a particle generator) owns a Random
+// seeded from the stream of the thread creating it
+class Random {
+public:
+	Random();
+	Random(uint64_t seed);
+
+	void seed(uint64_t seed);
+	// skip 2^64 numbers, streams jumped different times never overlap
+	void jump();
+
+	uint32_t next();
+	uint64_t next64();
+	// [0, 1)
+	float nextFloat();
+	// [min, max)
+	float nextFloat(float min, float max);
+	// [min, max)
+	int nextInt(int min, int max);
+	// uniform on the unit sphere
+	glm::vec3 nextUnitVector();
+
+	void fillFloats(float* out, int count, float min = 0, float max = 1);
+	void fillUnitVectors(glm::vec3* out, int count);
+
+	// stream of the calling thread
+	static Random& local();
+	// seed the stream of every thread again, for a reproducible run, no job may be running
+	static void setSeed(uint64_t seed);
+
+private:
+	uint32_t s[4];
+};
+
+// uniform directions in a cone around an axis, the basis of the axis is made once in set()
+class ConeSampler {
+public:
+	ConeSampler();
+	ConeSampler(glm::vec3 direction, float angleDegrees);
+
+	void set(glm::vec3 direction, float angleDegrees);
+
+	glm::vec3 sample(Random& random) const;
+	void fill(Random& random, glm::vec3* out, int count) const;
+
+private:
+	glm::vec3 axis;
+	glm::vec3 tangent;
+	glm::vec3 bitangent;
+	float cosAngle;
+};
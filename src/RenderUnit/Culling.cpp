@@ -0,0 +1,103 @@
+#include "Culling.h"
+#include <cfloat>
+
+AABB::AABB() {
+	min = glm::vec3(FLT_MAX);
+	max = glm::vec3(-FLT_MAX);
+}
+
+AABB::AABB(const glm::vec3& min, const glm::vec3& max) {
+	this->min = min;
+	this->max = max;
+}
+
+bool AABB::isEmpty() const {
+	return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+glm::vec3 AABB::center() const {
+	return (min + max) * 0.5f;
+}
+
+glm::vec3 AABB::extent() const {
+	return (max - min) * 0.5f;
+}
+
+void AABB::expand(const glm::vec3& point) {
+	min = glm::min(min, point);
+	max = glm::max(max, point);
+}
+
+void AABB::expand(const AABB& box) {
+	if (box.isEmpty())
+		return;
+	min = glm::min(min, box.min);
+	max = glm::max(max, box.max);
+}
+
+void AABB::pad(float amount) {
+	min -= glm::vec3(amount);
+	max += glm::vec3(amount);
+}
+
+// transform the center, and project the extent on the absolute axes of the matrix (Arvo)
+AABB AABB::transform(const glm::mat4& matrix) const {
+	if (isEmpty())
+		return AABB();
+	glm::vec3 c = glm::vec3(matrix * glm::vec4(center(), 1.0f));
+	glm::vec3 e = extent();
+	glm::vec3 newExtent(0.0f);
+	for (int i = 0; i < 3; i++) {
+		newExtent += glm::abs(glm::vec3(matrix[i])) * e[i];
+	}
+	return AABB(c - newExtent, c + newExtent);
+}
+
+Frustum::Frustum() {
+	// everything is visible before the first update
+	for (int i = 0; i < 6; i++)
+		planes[i] = glm::vec4(0, 0, 0, 1);
+}
+
+// extract planes from the rows of the clip matrix (Gribb & Hartmann)
+void Frustum::update(const glm::mat4& viewProjection) {
+	glm::vec4 row[4];
+	for (int i = 0; i < 4; i++)
+		row[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+	planes[0] = row[3] + row[0];	// left
+	planes[1] = row[3] - row[0];	// right
+	planes[2] = row[3] + row[1];	// bottom
+	planes[3] = row[3] - row[1];	// top
+	planes[4] = row[3] + row[2];	// near
+	planes[5] = row[3] - row[2];	// far
+
+	for (int i = 0; i < 6; i++) {
+		float len = glm::length(glm::vec3(planes[i]));
+		if (len > 0)
+			planes[i] /= len;
+	}
+}
+
+// the box is outside if its most positive corner is behind any plane
+bool Frustum::isVisible(const AABB& box) const {
+	if (box.isEmpty())
+		return false;
+	for (int i = 0; i < 6; i++) {
+		glm::vec3 p(
+			planes[i].x > 0 ? box.max.x : box.min.x,
+			planes[i].y > 0 ? box.max.y : box.min.y,
+			planes[i].z > 0 ? box.max.z : box.min.z);
+		if (glm::dot(glm::vec3(planes[i]), p) + planes[i].w < 0)
+			return false;
+	}
+	return true;
+}
+
+bool Frustum::isVisible(const glm::vec3& center, float radius) const {
+	for (int i = 0; i < 6; i++) {
+		if (glm::dot(glm::vec3(planes[i]), center) + planes[i].w < -radius)
+			return false;
+	}
+	return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <glm/glm.hpp>
+
+//axis aligned bounding box, a default one is empty (min > max)
+struct AABB {
+	glm::vec3 min;
+	glm::vec3 max;
+
+	AABB();
+	AABB(const glm::vec3& min, const glm::vec3& max);
+
+	bool isEmpty() const;
+	glm::vec3 center() const;
+	glm::vec3 extent() const;	// half size
+
+	void expand(const glm::vec3& point);
+	void expand(const AABB& box);
+	void pad(float amount);
+	// box that encloses this box after transform by the matrix
+	AABB transform(const glm::mat4& matrix) const;
+};
+
+//view frustum made by the six planes of a view-projection matrix
+class Frustum {
+private:
+	glm::vec4 planes[6];	// (normal, distance), normal point to the inside
+
+public:
+	Frustum();
+
+	void update(const glm::mat4& viewProjection);
+	bool isVisible(const AABB& box) const;
+	bool isVisible(const glm::vec3& center, float radius) const;
+};
@@ -0,0 +1,78 @@
+#include "DynamicResolution.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+
+#define TARGET_FRAME_TIME (1000.0f / 60.0f)	// ms
+#define MIN_SCALE 0.5f
+#define TIME_SMOOTHING 0.1f	// weight of the newest frame
+#define HEADROOM 0.9f	// aim under the target, so a spike doesn't miss it
+#define MAX_STEP 0.05f	// the most the scale change in a frame
+#define SCALE_QUANTUM 0.025f	// small changes are ignored, the image doesn't shimmer
+
+DynamicResolution::DynamicResolution() {
+}
+
+DynamicResolution::~DynamicResolution() {
+	if (queries[0] != 0)
+		glDeleteQueries(QUERY_AMOUNT, queries);
+}
+
+void DynamicResolution::init() {
+	glGenQueries(QUERY_AMOUNT, queries);
+}
+
+void DynamicResolution::setEnabled(bool isEnabled) {
+	enabled = isEnabled;
+	if (!enabled)
+		scale = 1.0f;
+}
+
+void DynamicResolution::readResults() {
+	for (int i = 0; i < QUERY_AMOUNT; i++) {
+		if (!isPending[i])
+			continue;
+		int available = 0;
+		glGetQueryObjectiv(queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			continue;
+		GLuint64 elapsed = 0;
+		glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &elapsed);
+		isPending[i] = false;
+		float time = elapsed / 1000000.0f;
+		frameTime = frameTime == 0 ? time : frameTime + (time - frameTime) * TIME_SMOOTHING;
+	}
+}
+
+void DynamicResolution::beginFrame() {
+	if (queries[0] == 0)
+		return;
+	current = (current + 1) % QUERY_AMOUNT;
+	readResults();
+
+	if (enabled && frameTime > 0) {
+		// the cost is about the amount of pixels, so the square root of the time ratio
+		float wanted = scale * std::sqrt(TARGET_FRAME_TIME * HEADROOM / frameTime);
+		wanted = std::max(MIN_SCALE, std::min(1.0f, wanted));
+		if (std::abs(wanted - scale) >= SCALE_QUANTUM)
+			scale += std::max(-MAX_STEP, std::min(MAX_STEP, wanted - scale));
+	}
+
+	// the slot is still in use by a frame the GPU hasn't finished, it is not timed
+	if (isPending[current])
+		return;
+	glBeginQuery(GL_TIME_ELAPSED, queries[current]);
+	isTiming = true;
+}
+
+void DynamicResolution::endFrame() {
+	if (!isTiming)
+		return;
+	glEndQuery(GL_TIME_ELAPSED);
+	isPending[current] = true;
+	isTiming = false;
+}
+
+int DynamicResolution::scaled(int size) const {
+	return std::max(1, (int)std::lround(size * scale));
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+// the scale of the 3D scene, picked every frame to hold a target GPU frame time
+// the frame is timed by GL timer queries, a result is read QUERY_AMOUNT - 1 frames later, so the CPU never wait for the GPU
+// the scene is drawn into the lower left part of the full size frame buffer, so a new scale costs no new texture,
+// and frame.frag upscales that part to the window
+class DynamicResolution {
+public:
+	static const int QUERY_AMOUNT = 4;
+
+private:
+	unsigned int queries[QUERY_AMOUNT] = {};
+	bool isPending[QUERY_AMOUNT] = {};
+	int current = 0;	// the query of this frame
+	bool isTiming = false;
+
+	bool enabled = false;
+	float scale = 1.0f;
+	float frameTime = 0;	// ms, smoothed over the frames
+
+	void readResults();
+
+public:
+	DynamicResolution();
+	~DynamicResolution();
+
+	void init();
+
+	// back to the full resolution when disabled
+	void setEnabled(bool isEnabled);
+
+	// pick the scale by the frame time known so far, and start timing this frame
+	void beginFrame();
+	void endFrame();
+
+	float getScale() const { return scale; }
+	// the size of the scene for a size of the window
+	int scaled(int size) const;
+	float getFrameTime() const { return frameTime; }
+};
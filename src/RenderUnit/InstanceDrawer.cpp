@@ -2,6 +2,11 @@
 #include "InstanceDrawer.h"
 #include <glad/glad.h>
 
+void InstanceMatrices::add(const glm::mat4& modelMatrix) {
+	modelMatrices.push_back(modelMatrix);
+	normalMatrices.push_back(glm::transpose(glm::inverse(modelMatrix)));
+}
+
 InstanceDrawer::InstanceDrawer() {
 	this->instanceVBO[0] = 0;
 	this->instanceVBO[1] = 0;
@@ -23,10 +28,32 @@ InstanceDrawer::InstanceDrawer(const Material& m) {
 
 void InstanceDrawer::addModelMatrix(glm::mat4 modelMatrix)
 {
+	queuedInstance = -1;
 	modelMatrices.push_back(modelMatrix);
 	normalMatrices.push_back(glm::transpose(glm::inverse(modelMatrix)));
 }
 
+void InstanceDrawer::addModelMatrices(const InstanceMatrices& matrices)
+{
+	queuedInstance = -1;
+	modelMatrices.insert(modelMatrices.end(), matrices.modelMatrices.begin(), matrices.modelMatrices.end());
+	normalMatrices.insert(normalMatrices.end(), matrices.normalMatrices.begin(), matrices.normalMatrices.end());
+}
+
+void InstanceDrawer::addModelMatrix(const glm::mat4& modelMatrix, const glm::mat4& normalMatrix)
+{
+	queuedInstance = -1;
+	modelMatrices.push_back(modelMatrix);
+	normalMatrices.push_back(normalMatrix);
+}
+
+void InstanceDrawer::addModelMatrices(const glm::mat4* models, const glm::mat4* normals, int count)
+{
+	queuedInstance = -1;
+	modelMatrices.insert(modelMatrices.end(), models, models + count);
+	normalMatrices.insert(normalMatrices.end(), normals, normals + count);
+}
+
 void InstanceDrawer::setMaterial(const Material& m) {
 	material = m;
 }
@@ -36,6 +63,11 @@ void InstanceDrawer::setTexture(unsigned int id)
 	textureId = id;
 }
 
+void InstanceDrawer::setOutlined(bool outlined)
+{
+	isOutlined = outlined;
+}
+
 //draw the object by all model matrix, the model ande normal matrix will be clear after drawed
 // if you will draw it for the second time, set "doClear" to false
 void InstanceDrawer::drawByInstance(Shader* shader, Object& object, bool doClear){
@@ -43,6 +75,7 @@ void InstanceDrawer::drawByInstance(Shader* shader, Object& object, bool doClear
 		glGenBuffers(2, this->instanceVBO);
 	}
 	glBindVertexArray(object.VAO);
+	shader = shader->variant(this->textureId != (unsigned int)-1 ? SHADER_USE_IMAGE : 0);
 	shader->use();
 
 	// material properties
@@ -52,15 +85,11 @@ void InstanceDrawer::drawByInstance(Shader* shader, Object& object, bool doClear
 	shader->setFloat("material.shininess", material.shininess);
 
 	// set texture
-	if (this->textureId != -1) {
+	if (this->textureId != (unsigned int)-1) {
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, textureId);
-		shader->setBool("useImage", true);
 		shader->setInt("imageTexture", 0);
 	}
-	else {
-		shader->setBool("useImage", false);
-	}	
 
 	//-------------------
 	// set instance VBO
@@ -86,19 +115,27 @@ void InstanceDrawer::drawByInstance(Shader* shader, Object& object, bool doClear
 	}
 
 	glDrawElementsInstanced(GL_TRIANGLES, object.element_amount, GL_UNSIGNED_INT, 0, modelMatrices.size());
-	//unbind VAO
-	glBindVertexArray(0);
-	//unbind Texture
-	glBindTexture(GL_TEXTURE_2D, 0);
-	//unbind shader(switch to fixed pipeline)
-	glUseProgram(0);
 
+	// give the memory back, the drawer may live longer than the frame arena
 	if (doClear) {
-		modelMatrices.clear();
-		normalMatrices.clear();
+		ArenaVector<glm::mat4>().swap(modelMatrices);
+		ArenaVector<glm::mat4>().swap(normalMatrices);
 	}
 }
 
+void InstanceDrawer::submit(RenderQueue& queue, RenderQueue::Pass pass, Shader* shader, const Object& object) {
+	if (queuedInstance < 0) {
+		queuedAmount = (int)modelMatrices.size();
+		queuedInstance = queue.addInstances(modelMatrices.data(), normalMatrices.data(), queuedAmount);
+		ArenaVector<glm::mat4>().swap(modelMatrices);
+		ArenaVector<glm::mat4>().swap(normalMatrices);
+	}
+	// the shadows don't sample the texture, so the textured drawers batch with the others
+	bool useTexture = this->textureId != (unsigned int)-1 && pass == RenderQueue::PASS_OPAQUE;
+	queue.submitInstances(pass, shader->variant(useTexture ? SHADER_USE_IMAGE : 0), object, material, useTexture ? textureId : (unsigned int)-1, queuedInstance, queuedAmount,
+		isOutlined && pass == RenderQueue::PASS_OPAQUE);
+}
+
 void InstanceDrawer::addParticleAttribute(Particle attribute) {
 	particlAttributes.push_back(attribute);
 }
@@ -144,9 +181,6 @@ void InstanceDrawer::drawParticleByInstance(Shader* shader, const unsigned int p
 	//unbind VAO
 	glBindVertexArray(0);
 
-	//unbind shader(switch to fixed pipeline)
-	glUseProgram(0);
-
-	particlAttributes.clear();
+	ArenaVector<Particle>().swap(particlAttributes);
 }
 
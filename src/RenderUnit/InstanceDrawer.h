@@ -3,21 +3,35 @@
 #include <string>
 #include "RenderStructure.h"
 #include "Shader.h"
+#include "RenderQueue.h"
 #include <glm/glm.hpp>
+#include "../FrameArena.h"
+
+// model and normal matrices made outside a drawer, e.g. on a worker thread
+struct InstanceMatrices {
+	ArenaVector<glm::mat4> modelMatrices;
+	ArenaVector<glm::mat4> normalMatrices;
+
+	void add(const glm::mat4& modelMatrix);
+};
 
 class InstanceDrawer {
 private:
-	//for object
-	std::vector<glm::mat4> modelMatrices;
-	std::vector<glm::mat4> normalMatrices;
+	//for object, on the frame arena and released after drawed
+	ArenaVector<glm::mat4> modelMatrices;
+	ArenaVector<glm::mat4> normalMatrices;
 	Material material;
 	unsigned int textureId=-1;
 
 	GLuint instanceVBO[2];
+	// the instances already added to a render queue this frame, -1 if not
+	int queuedInstance = -1;
+	int queuedAmount = 0;
+	bool isOutlined = false;
 
 
 	//for particle
-	std::vector<Particle> particlAttributes;
+	ArenaVector<Particle> particlAttributes;
 
 public:
 	InstanceDrawer();
@@ -25,9 +39,17 @@ public:
 	~InstanceDrawer();
 
 	void addModelMatrix(glm::mat4 modelMatrix);
+	void addModelMatrices(const InstanceMatrices& matrices);
+	// with a normal matrix cached by the caller
+	void addModelMatrix(const glm::mat4& modelMatrix, const glm::mat4& normalMatrix);
+	void addModelMatrices(const glm::mat4* models, const glm::mat4* normals, int count);
 	void setMaterial(const Material& m);
 	void setTexture(unsigned int id);
+	// drawn into the mask of the outlines by a render queue
+	void setOutlined(bool outlined);
 	void drawByInstance(Shader* shader, Object &object, bool doClear = true);
+	// the matrices are copied into the queue once and given back, the drawer can be submitted to every pass of the frame
+	void submit(RenderQueue& queue, RenderQueue::Pass pass, Shader* shader, const Object& object);
 
 	void addParticleAttribute(Particle attribute);
 	void drawParticleByInstance(Shader* shader, const unsigned int particleVAO);
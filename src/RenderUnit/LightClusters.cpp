@@ -0,0 +1,122 @@
+#include "LightClusters.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+
+#define CLUSTER_AMOUNT (LightClusters::TILES_X * LightClusters::TILES_Y * LightClusters::SLICES)
+#define CULL_GROUP_SIZE 64	// local_size_x of lightClusters.comp
+
+LightClusters::LightClusters() {
+}
+
+LightClusters::~LightClusters() {
+	unsigned int buffers[] = { paramsUBO, lightSSBO, countSSBO, indexSSBO };
+	for (unsigned int buffer : buffers) {
+		if (buffer != 0)
+			glDeleteBuffers(1, &buffer);
+	}
+}
+
+void LightClusters::init(Shader* shader) {
+	cullShader = shader;
+
+	glGenBuffers(1, &paramsUBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, paramsUBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(Params), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, CLUSTER_BLOCK_BINDING, paramsUBO);
+
+	// the light list start with its amount, padded to a vec4
+	glGenBuffers(1, &lightSSBO);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightSSBO);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::uvec4) + MAX_LIGHTS * sizeof(GpuLight), NULL, GL_DYNAMIC_DRAW);
+	glm::uvec4 empty(0);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(empty), &empty);
+	glGenBuffers(1, &countSSBO);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, countSSBO);
+	std::vector<unsigned int> zeros(CLUSTER_AMOUNT, 0);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, CLUSTER_AMOUNT * sizeof(unsigned int), zeros.data(), GL_DYNAMIC_COPY);
+	glGenBuffers(1, &indexSSBO);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, indexSSBO);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, CLUSTER_AMOUNT * MAX_LIGHTS_PER_CLUSTER * sizeof(unsigned int), NULL, GL_DYNAMIC_COPY);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, lightSSBO);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, countSSBO);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, indexSSBO);
+}
+
+void LightClusters::addFlash(const glm::vec3& position, const glm::vec3& color, float radius, float duration) {
+	// a full list keeps the older lights, they are brighter than the new ones will be when the list frees
+	if ((int)flashes.size() >= MAX_LIGHTS || duration <= 0)
+		return;
+	flashes.push_back({ position, color, radius, duration, duration });
+}
+
+void LightClusters::advance(float time) {
+	for (Flash& flash : flashes)
+		flash.life -= time;
+	flashes.erase(std::remove_if(flashes.begin(), flashes.end(), [](const Flash& flash) { return flash.life <= 0; }), flashes.end());
+}
+
+int LightClusters::lightAmount() const {
+	return (int)flashes.size();
+}
+
+void LightClusters::update(const glm::mat4& view, const glm::mat4& projection, const glm::ivec4& viewport) {
+	if (cullShader == nullptr)
+		return;
+
+	Params params;
+	params.view = view;
+	params.projection = projection;
+	params.inverseProjection = glm::inverse(projection);
+	params.viewport = glm::vec4(viewport);
+	// the view distance of the near and far planes, from the projection matrix
+	bool isPerspective = projection[2][3] < -0.5f;
+	float nearPlane, farPlane;
+	if (isPerspective) {
+		nearPlane = projection[3][2] / (projection[2][2] - 1);
+		farPlane = projection[3][2] / (projection[2][2] + 1);
+	}
+	else {
+		nearPlane = (projection[3][2] + 1) / projection[2][2];
+		farPlane = (projection[3][2] - 1) / projection[2][2];
+		// glOrtho of the top view has near > far
+		if (nearPlane > farPlane)
+			std::swap(nearPlane, farPlane);
+	}
+	// perspective slices grow with the distance, slice = log(distance) * scale + bias
+	float logScale = 0, logBias = 0;
+	if (isPerspective && nearPlane > 0 && farPlane > nearPlane) {
+		logScale = SLICES / std::log(farPlane / nearPlane);
+		logBias = -SLICES * std::log(nearPlane) / std::log(farPlane / nearPlane);
+	}
+	params.depth = glm::vec4(nearPlane, farPlane, logScale, logBias);
+	params.grid = glm::uvec4(TILES_X, TILES_Y, SLICES, isPerspective ? 1 : 0);
+
+	gpuLights.clear();
+	for (const Flash& flash : flashes) {
+		float fade = flash.life / flash.duration;
+		gpuLights.push_back({ glm::vec4(flash.position, flash.radius), glm::vec4(flash.color * fade, 1.0f) });
+	}
+	glm::uvec4 header((unsigned int)gpuLights.size(), 0, 0, 0);
+
+	glBindBuffer(GL_UNIFORM_BUFFER, paramsUBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Params), &params);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, lightSSBO);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(header), &header);
+	if (!gpuLights.empty())
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(header), gpuLights.size() * sizeof(GpuLight), gpuLights.data());
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	// the fragments skip the clusters when the amount is 0, the old lists are never read
+	if (gpuLights.empty())
+		return;
+
+	cullShader->use();
+	glDispatchCompute((CLUSTER_AMOUNT + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+	// the lit fragment shaders read the lists
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
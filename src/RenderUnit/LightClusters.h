@@ -0,0 +1,64 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "Shader.h"
+
+// clustered forward lighting for many short lived point lights, e.g. the explosions
+// the view frustum is cut into froxel clusters (screen tiles x depth slices), a compute pass lists the lights
+// touching every cluster, and a fragment only lights itself by the lights of its own cluster (lighting.glsl)
+// the buffers are bound to the uniform block "Clusters" (binding 1) and the storage blocks 0, 1, 2 of clusters.glsl
+class LightClusters {
+public:
+	static const int TILES_X = 16;
+	static const int TILES_Y = 9;
+	static const int SLICES = 24;
+	static const int MAX_LIGHTS_PER_CLUSTER = 64;	// the same as clusters.glsl
+	static const int MAX_LIGHTS = 1024;
+	static const int CLUSTER_BLOCK_BINDING = 1;
+
+private:
+	// std430 layout of clusters.glsl
+	struct GpuLight {
+		glm::vec4 positionRadius;
+		glm::vec4 color;
+	};
+	// std140 layout of the block Clusters
+	struct Params {
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::mat4 inverseProjection;
+		glm::vec4 viewport;	// x, y, width, height
+		glm::vec4 depth;	// near, far, log scale, log bias
+		glm::uvec4 grid;	// tiles x, tiles y, slices, 1 if perspective
+	};
+	struct Flash {
+		glm::vec3 position;
+		glm::vec3 color;
+		float radius;
+		float life;
+		float duration;
+	};
+	std::vector<Flash> flashes;
+	std::vector<GpuLight> gpuLights;
+
+	Shader* cullShader = nullptr;
+	unsigned int paramsUBO = 0;
+	unsigned int lightSSBO = 0;
+	unsigned int countSSBO = 0;
+	unsigned int indexSSBO = 0;
+
+public:
+	LightClusters();
+	~LightClusters();
+
+	// shader is lightClusters.comp
+	void init(Shader* shader);
+
+	// a light fading out in duration ticks
+	void addFlash(const glm::vec3& position, const glm::vec3& color, float radius, float duration);
+	void advance(float time);
+	int lightAmount() const;
+
+	// upload the lights and assign them to the clusters of this view, before the lit shaders draw
+	void update(const glm::mat4& view, const glm::mat4& projection, const glm::ivec4& viewport);
+};
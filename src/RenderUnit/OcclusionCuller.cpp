@@ -0,0 +1,106 @@
+#include "OcclusionCuller.h"
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+// queries unused for this many frames are deleted
+#define OCCLUSION_QUERY_LIFETIME 120
+
+OcclusionCuller::OcclusionCuller() {
+}
+
+OcclusionCuller::~OcclusionCuller() {
+	clear();
+}
+
+void OcclusionCuller::init(Shader* shader, const Object& unitCube) {
+	boxShader = shader;
+	boxVAO = unitCube.VAO;
+	boxElementAmount = unitCube.element_amount;
+}
+
+void OcclusionCuller::beginFrame() {
+	frame++;
+	for (auto it = queries.begin(); it != queries.end();) {
+		Query& q = it->second;
+		if (q.pending) {
+			GLuint available = 0;
+			glGetQueryObjectuiv(q.id, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available) {
+				GLuint samples = 0;
+				glGetQueryObjectuiv(q.id, GL_QUERY_RESULT, &samples);
+				q.visible = samples != 0;
+				q.pending = false;
+			}
+		}
+		if (!q.pending && frame - q.lastQueryFrame > OCCLUSION_QUERY_LIFETIME) {
+			glDeleteQueries(1, &q.id);
+			it = queries.erase(it);
+		}
+		else
+			++it;
+	}
+	issueList.clear();
+}
+
+bool OcclusionCuller::isVisible(long long key) const {
+	auto it = queries.find(key);
+	if (it == queries.end())
+		return true;
+	// the box was out of the frustum (or not asked) last frame, its result is too old
+	if (it->second.lastQueryFrame < frame - 1)
+		return true;
+	return it->second.visible;
+}
+
+void OcclusionCuller::query(long long key, const AABB& box) {
+	Query& q = queries[key];
+	if (q.id == 0)
+		glGenQueries(1, &q.id);
+	q.box = box;
+	q.lastQueryFrame = frame;
+	// still waiting for the last one, keep the old result
+	if (q.pending)
+		return;
+	issueList.push_back(key);
+}
+
+void OcclusionCuller::flush(const glm::vec3& eyePos) {
+	if (issueList.empty() || boxShader == nullptr)
+		return;
+
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+	boxShader->use();
+	glBindVertexArray(boxVAO);
+	for (size_t i = 0; i < issueList.size(); i++) {
+		Query& q = queries[issueList[i]];
+		// the near plane would clip the box if the eye is inside, so it must be visible
+		AABB eyeBox = q.box;
+		eyeBox.pad(1.0f);
+		if (glm::all(glm::greaterThanEqual(eyePos, eyeBox.min)) && glm::all(glm::lessThanEqual(eyePos, eyeBox.max))) {
+			q.visible = true;
+			continue;
+		}
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), q.box.center());
+		model = glm::scale(model, q.box.extent() * 2.0f);
+		boxShader->setMat4("model", model);
+
+		glBeginQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE, q.id);
+		glDrawElements(GL_TRIANGLES, boxElementAmount, GL_UNSIGNED_INT, 0);
+		glEndQuery(GL_ANY_SAMPLES_PASSED_CONSERVATIVE);
+		q.pending = true;
+	}
+	glBindVertexArray(0);
+	glDepthMask(GL_TRUE);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	issueList.clear();
+}
+
+void OcclusionCuller::clear() {
+	for (auto it = queries.begin(); it != queries.end(); ++it) {
+		if (it->second.id != 0)
+			glDeleteQueries(1, &it->second.id);
+	}
+	queries.clear();
+	issueList.clear();
+}
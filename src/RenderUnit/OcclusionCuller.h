@@ -0,0 +1,45 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "RenderStructure.h"
+#include "Shader.h"
+#include "Culling.h"
+
+// hardware occlusion queries against bounding boxes
+// the result of a query is read in the next frame (or later), so the CPU never wait for the GPU
+// a box is treated as visible until its query has an answer
+class OcclusionCuller {
+private:
+	struct Query {
+		unsigned int id = 0;
+		AABB box;
+		bool pending = false;	// issued and the result is not read yet
+		bool visible = true;	// last known result
+		long long lastQueryFrame = -1;
+	};
+	std::unordered_map<long long, Query> queries;
+	std::vector<long long> issueList;	// keys queried in this frame
+
+	Shader* boxShader = nullptr;
+	unsigned int boxVAO = 0;	// unit cube centered at origin
+	unsigned int boxElementAmount = 0;
+	long long frame = 0;
+
+public:
+	OcclusionCuller();
+	~OcclusionCuller();
+
+	void init(Shader* shader, const Object& unitCube);
+
+	// collect the results which are ready, and start a new frame
+	void beginFrame();
+	// last known result, true if the box was never tested or was not tested last frame
+	bool isVisible(long long key) const;
+	// ask for a query of this box in this frame, drawn when flush
+	void query(long long key, const AABB& box);
+	// draw the boxes of this frame against the current depth buffer
+	void flush(const glm::vec3& eyePos);
+	// drop all queries, e.g. the keys mean something else now
+	void clear();
+};
@@ -1,7 +1,9 @@
 #include "ParticleSystem.h"
 #include "InstanceDrawer.h"
 #include "../MathHelper.h"
+#include "../JobSystem.h"
 #include <cmath>
+#include <algorithm>
 
 //---------------Particle System-----------------
 
@@ -37,13 +39,21 @@ void ParticleSystem::deleteParticleGenerator(ParticleGenerator* generator) {
 }
 
 //draw and update all particle generator
+//the generators are independent, so they are updated on all threads
 void ParticleSystem::update() {
-	for (auto &p : particleGenerators) {
-		p.update();
-		if (p.lifeCount > 0) {
-			p.lifeCount -= RenderDatabase::timeScale;
-		}
+	updateList.clear();
+	for (auto& p : particleGenerators) {
+		updateList.push_back(&p);
 	}
+	JobSystem::get().parallelFor(0, (int)updateList.size(), 1, [this](int first, int last) {
+		for (int i = first; i < last; i++) {
+			ParticleGenerator& p = *updateList[i];
+			p.update();
+			if (p.lifeCount > 0) {
+				p.lifeCount -= RenderDatabase::timeScale;
+			}
+		}
+	});
 	particleGenerators.remove_if(ParticleSystem::isDead);
 }
 
@@ -105,24 +115,34 @@ ParticleGenerator::ParticleGenerator(Shader* shader, unsigned int particleVAO){
 	this->color2 = glm::vec3(1, 1, 1);
 	this->color3 = glm::vec3(1, 1, 1);
 	this->colorTransitionPoint = 0.5;
+	this->random.seed(Random::local().next64());
+	this->coneSampler.set(direction, angle);
 }
 
 void ParticleGenerator::update() {
 	//generate new particle
 	if (lifeCount > 0 || lifeCount <= ParticleGenerator::PERMANENT_LIFE_THRESHOLD) { //still alive
 		particleGenerateCounter += generateRate * RenderDatabase::timeScale;
-		while (particleGenerateCounter >= 1) {
-			ParticleEntity newParticle;
-			newParticle.attribute.position = position;
-			newParticle.attribute.color = MathHelper::gradientColor(color1, color2, color3, colorTransitionPoint, 0);
-			newParticle.attribute.size = particleSize;
-			float particleInitVelocity = particleVelocity + (MathHelper::randomFloat() * 2 - 1.0f) * particleVelocityRandomOffset;
-			newParticle.attribute.velocity = MathHelper::randomDirectionInCone(direction, angle) * particleInitVelocity;
-			int life = std::roundf(particleLife + (MathHelper::randomFloat() * 2 - 1.0f) * particleLifeRandomOffset);
-			newParticle.lifeCount = life;
-			particles.push_back(newParticle);
-
-			particleGenerateCounter -= 1.0f;
+		int newCount = (int)particleGenerateCounter;
+		particleGenerateCounter -= newCount;
+		if (newCount > 0) {
+			// all random numbers of the new particles at once
+			newDirections.resize(newCount);
+			newOffsets.resize(newCount * 2);	// velocity and life, [-1, 1)
+			coneSampler.fill(random, newDirections.data(), newCount);
+			random.fillFloats(newOffsets.data(), newCount * 2, -1, 1);
+			glm::vec3 startColor = MathHelper::gradientColor(color1, color2, color3, colorTransitionPoint, 0);
+			for (int i = 0; i < newCount; i++) {
+				ParticleEntity newParticle;
+				newParticle.attribute.position = position;
+				newParticle.attribute.color = startColor;
+				newParticle.attribute.size = particleSize;
+				float particleInitVelocity = particleVelocity + newOffsets[i * 2] * particleVelocityRandomOffset;
+				newParticle.attribute.velocity = newDirections[i] * particleInitVelocity;
+				int life = std::roundf(particleLife + newOffsets[i * 2 + 1] * particleLifeRandomOffset);
+				newParticle.lifeCount = life;
+				particles.push_back(newParticle);
+			}
 		}
 	}
 	
@@ -139,7 +159,7 @@ void ParticleGenerator::update() {
 		p.attribute.color = MathHelper::gradientColor(color1, color2, color3, colorTransitionPoint, (float)(particleLife - p.lifeCount) / particleLife);
 		p.lifeCount -= RenderDatabase::timeScale;
 	}
-	particles.remove_if(ParticleGenerator::isDead);
+	particles.erase(std::remove_if(particles.begin(), particles.end(), ParticleGenerator::isDead), particles.end());
 }
 
 void ParticleGenerator::draw() {
@@ -176,10 +196,12 @@ void ParticleGenerator::setGenerateRate(float rate) {
 
 void ParticleGenerator::setDirection(glm::vec3 dir) {
 	direction = dir;
+	coneSampler.set(direction, angle);
 }
 
 void ParticleGenerator::setAngle(float a) {
 	angle = a;
+	coneSampler.set(direction, angle);
 }
 
 void ParticleGenerator::setParticleSize(float size) {
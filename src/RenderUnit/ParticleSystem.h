@@ -1,15 +1,18 @@
 #pragma once
 #include <glm/glm.hpp>
 #include <list>
+#include <vector>
 #include "Shader.h"
 #include "RenderStructure.h"
 #include "InstanceDrawer.h"
+#include "../Random.h"
 
 class ParticleGenerator;
 
 class ParticleSystem{
 private:
 	std::list<ParticleGenerator> particleGenerators;
+	std::vector<ParticleGenerator*> updateList;	// generators of this update, for the jobs
 	unsigned int particleVAO;
 
 	static bool isDead(const ParticleGenerator& p);
@@ -70,7 +73,14 @@ private:
 	InstanceDrawer instanceDrawer;
 	unsigned int particleVAO;
 
-	std::list<ParticleEntity> particles;
+	std::vector<ParticleEntity> particles;	// keep its capacity, no allocation in a steady state
+	// random numbers of the new particles, kept like particles, update() runs in the tick where the frame arenas aren't reset
+	std::vector<glm::vec3> newDirections;
+	std::vector<float> newOffsets;
+
+	// its own stream, so the particles do not depend on the thread updating it
+	Random random;
+	ConeSampler coneSampler;	// of direction and angle
 
 	static bool isDead(const ParticleEntity& p);
 
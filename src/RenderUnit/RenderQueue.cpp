@@ -0,0 +1,244 @@
+#include "RenderQueue.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstring>
+
+#define MAX_SORT_DISTANCE 5000.0f	// farther items keep the order they are submitted in
+#define NO_STATE 0xFFFFFFFFu	// the bound state isn't known
+
+// 4 bits pass, 1 bit pre-passed, 1 bit outlined, 10 bits shader, 11 bits texture, 11 bits VAO, 16 bits depth
+static unsigned long long makeKey(RenderQueue::Pass pass, bool isPrepassed, bool isOutlined, unsigned int program, unsigned int texture, unsigned int VAO, float distance) {
+	unsigned long long depth = (unsigned long long)(glm::clamp(distance / MAX_SORT_DISTANCE, 0.0f, 1.0f) * 0xFFFF);
+	return ((unsigned long long)pass << 60)
+		| ((unsigned long long)isPrepassed << 59)
+		| ((unsigned long long)isOutlined << 58)
+		| ((unsigned long long)(program & 0x3FF) << 48)
+		| ((unsigned long long)(texture & 0x7FF) << 37)
+		| ((unsigned long long)(VAO & 0x7FF) << 26)
+		| (depth << 10);
+}
+
+// the second color attachment is only drawn by the outlined items
+static void setOutlining(bool isOutlining) {
+	const GLenum buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+	glDrawBuffers(isOutlining ? 2 : 1, buffers);
+}
+
+// the model matrix at 3-6 and the normal matrix at 7-10 of the bound VAO, from the instance buffer
+static void pointInstanceAttributes(unsigned int buffer) {
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	for (int j = 0; j < 4; j++) {
+		glVertexAttribPointer(3 + j, 4, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::mat4), (void*)(j * sizeof(glm::vec4)));
+		glEnableVertexAttribArray(3 + j);
+		glVertexAttribDivisor(3 + j, 1);
+		glVertexAttribPointer(7 + j, 4, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::mat4), (void*)(sizeof(glm::mat4) + j * sizeof(glm::vec4)));
+		glEnableVertexAttribArray(7 + j);
+		glVertexAttribDivisor(7 + j, 1);
+	}
+}
+
+RenderQueue::RenderQueue() {
+}
+
+RenderQueue::~RenderQueue() {
+	if (instanceVBO != 0)
+		glDeleteBuffers(1, &instanceVBO);
+}
+
+void RenderQueue::init() {
+	glGenBuffers(1, &instanceVBO);
+}
+
+void RenderQueue::beginFrame(const glm::vec3& eyePosition) {
+	eye = eyePosition;
+	items.clear();
+	instanceData.clear();
+	customDraws.clear();
+	uploadedSize = 0;
+}
+
+float RenderQueue::distanceTo(const glm::vec3& position) const {
+	return glm::length(position - eye);
+}
+
+void RenderQueue::addItem(Item& item, float distance) {
+	// only the items in the depth buffer gain by the order of depth
+	if (item.pass != PASS_OPAQUE && item.pass != PASS_DEPTH)
+		distance = 0;
+	unsigned int texture = item.type == ITEM_MESH && item.useTextures && !item.mesh->textures.empty() ? item.mesh->textures[0].id : item.textureId;
+	item.key = makeKey(item.pass, item.isPrepassed, item.isOutlined, item.shader->ID, texture, item.VAO, distance);
+	items.push_back(item);
+}
+
+int RenderQueue::addInstances(const glm::mat4* models, const glm::mat4* normals, int count) {
+	int first = (int)(instanceData.size() / 2);
+	for (int i = 0; i < count; i++) {
+		instanceData.push_back(models[i]);
+		instanceData.push_back(normals[i]);
+	}
+	return first;
+}
+
+void RenderQueue::submitInstances(Pass pass, Shader* shader, const Object& object, const Material& material, unsigned int textureId, int firstInstance, int instanceAmount, bool isOutlined) {
+	if (instanceAmount <= 0)
+		return;
+	Item item = {};
+	item.type = ITEM_INSTANCES;
+	item.pass = pass;
+	item.shader = shader;
+	item.VAO = object.VAO;
+	item.elementAmount = object.element_amount;
+	item.firstInstance = firstInstance;
+	item.instanceAmount = instanceAmount;
+	item.material = material;
+	item.textureId = textureId;
+	item.isOutlined = isOutlined;
+	// the nearest instance
+	float distance = MAX_SORT_DISTANCE;
+	if (pass == PASS_OPAQUE) {
+		for (int i = firstInstance; i < firstInstance + instanceAmount; i++)
+			distance = std::min(distance, distanceTo(glm::vec3(instanceData[i * 2][3])));
+	}
+	addItem(item, distance);
+}
+
+void RenderQueue::submitModel(Pass pass, Shader* shader, const Model& model, const glm::mat4& modelMatrix, bool useTextures, bool isPrepassed) {
+	float distance = distanceTo(glm::vec3(modelMatrix[3]));
+	for (const Mesh& mesh : model.getMeshes()) {
+		Item item = {};
+		item.type = ITEM_MESH;
+		item.pass = pass;
+		item.shader = shader;
+		item.VAO = pass == PASS_DEPTH ? mesh.getDepthVAO() : mesh.getVAO();
+		item.elementAmount = (unsigned int)mesh.indices.size();
+		item.textureId = NO_STATE;
+		item.mesh = &mesh;
+		item.useTextures = useTextures && pass != PASS_DEPTH;
+		item.model = modelMatrix;
+		item.isPrepassed = isPrepassed;
+		addItem(item, distance);
+	}
+}
+
+void RenderQueue::submitCustom(Pass pass, Shader* shader, const glm::vec3& position, const std::function<void()>& draw, bool isPrepassed) {
+	Item item = {};
+	item.type = ITEM_CUSTOM;
+	item.pass = pass;
+	item.shader = shader;
+	item.textureId = NO_STATE;
+	item.customIndex = (int)customDraws.size();
+	item.isPrepassed = isPrepassed;
+	customDraws.push_back(draw);
+	addItem(item, distanceTo(position));
+}
+
+void RenderQueue::flush(Pass pass) {
+	// the instances added since the last flush
+	if (instanceData.size() > uploadedSize) {
+		glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+		glBufferData(GL_ARRAY_BUFFER, instanceData.size() * sizeof(glm::mat4), instanceData.data(), GL_STREAM_DRAW);
+		uploadedSize = instanceData.size();
+	}
+
+	order.clear();
+	for (int i = 0; i < (int)items.size(); i++) {
+		if (items[i].pass == pass)
+			order.push_back(std::make_pair(items[i].key, i));
+	}
+	if (order.empty())
+		return;
+	std::sort(order.begin(), order.end());
+
+	if (pass == PASS_DEPTH)
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	bool isDepthEqual = false;
+	bool isOutlining = false;
+	Shader* boundShader = nullptr;
+	unsigned int boundVAO = NO_STATE;
+	unsigned int boundTexture = NO_STATE;
+	const Mesh* boundTextureMesh = nullptr;
+	const Material* boundMaterial = nullptr;
+	bool isSamplerSet = false;
+	for (const auto& entry : order) {
+		const Item& item = items[entry.second];
+		// they are sorted after the others, so the others can hide them too
+		if (item.isPrepassed && !isDepthEqual) {
+			glDepthFunc(GL_EQUAL);
+			glDepthMask(GL_FALSE);
+			isDepthEqual = true;
+		}
+		if (item.isOutlined != isOutlining) {
+			setOutlining(item.isOutlined);
+			isOutlining = item.isOutlined;
+		}
+		if (item.shader != boundShader) {
+			item.shader->use();
+			boundShader = item.shader;
+			// the uniforms are of the program
+			boundMaterial = nullptr;
+			boundTextureMesh = nullptr;
+			isSamplerSet = false;
+		}
+
+		if (item.type == ITEM_CUSTOM) {
+			customDraws[item.customIndex]();
+			// the draw may have bound anything
+			boundShader = nullptr;
+			boundVAO = NO_STATE;
+			boundTexture = NO_STATE;
+			continue;
+		}
+
+		if (item.VAO != boundVAO) {
+			glBindVertexArray(item.VAO);
+			if (item.type == ITEM_INSTANCES)
+				pointInstanceAttributes(instanceVBO);
+			boundVAO = item.VAO;
+		}
+
+		if (item.type == ITEM_INSTANCES) {
+			if (boundMaterial == nullptr || memcmp(boundMaterial, &item.material, sizeof(Material)) != 0) {
+				item.shader->setVec3("material.ambient", item.material.ambient);
+				item.shader->setVec3("material.diffuse", item.material.diffuse);
+				item.shader->setVec3("material.specular", item.material.specular);
+				item.shader->setFloat("material.shininess", item.material.shininess);
+				boundMaterial = &item.material;
+			}
+			if (item.textureId != NO_STATE) {
+				if (item.textureId != boundTexture) {
+					glActiveTexture(GL_TEXTURE0);
+					glBindTexture(GL_TEXTURE_2D, item.textureId);
+					boundTexture = item.textureId;
+					boundTextureMesh = nullptr;
+				}
+				if (!isSamplerSet) {
+					item.shader->setInt("imageTexture", 0);
+					isSamplerSet = true;
+				}
+			}
+			glDrawElementsInstancedBaseInstance(GL_TRIANGLES, item.elementAmount, GL_UNSIGNED_INT, 0, item.instanceAmount, item.firstInstance);
+		}
+		else {
+			item.shader->setMat4("model", item.model);
+			if (item.useTextures && (boundTextureMesh == nullptr || !boundTextureMesh->hasSameTextures(*item.mesh))) {
+				item.mesh->bindTextures(item.shader);
+				boundTextureMesh = item.mesh;
+				boundTexture = NO_STATE;
+			}
+			glDrawElements(GL_TRIANGLES, item.elementAmount, GL_UNSIGNED_INT, 0);
+		}
+	}
+
+	if (isDepthEqual) {
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+	}
+	if (isOutlining)
+		setOutlining(false);
+	if (pass == PASS_DEPTH)
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+	// the program is left bound, the next draw binds its own
+	glBindVertexArray(0);
+	glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+#include "RenderStructure.h"
+#include "Shader.h"
+
+// the draws of a frame, sorted so only the state that changed is bound between them
+// the passes submit items during the frame and flush them, the items of a pass are sorted by the key
+// (pass, shader, texture, VAO, depth), so the opaque items of the same state are drawn front to back for early-Z
+// the instance matrices of all items are in one buffer, an item picks its range by the base instance
+// nothing is unbound between the items, the program is 0 again only at the end of a flush for the fixed pipeline
+// the items in the depth pre-pass are drawn with a depth test for equal in the opaque pass after the others,
+// so their expensive shading only runs on the pixels left visible
+// the outlined items are drawn into the second color attachment too, after the others of their pass
+class RenderQueue {
+public:
+	enum Pass {
+		PASS_SHADOW_STATIC,	// the static casters of ShadowMap, only flushed when they are drawn
+		PASS_SHADOW,
+		PASS_DEPTH,	// only the depth, the models are drawn by their positions only
+		PASS_OPAQUE,
+		PASS_AMOUNT
+	};
+
+private:
+	enum ItemType {
+		ITEM_INSTANCES,
+		ITEM_MESH,
+		ITEM_CUSTOM
+	};
+	struct Item {
+		unsigned long long key;
+		ItemType type;
+		Pass pass;
+		Shader* shader;
+		unsigned int VAO;
+		unsigned int elementAmount;
+		// instances
+		int firstInstance;
+		int instanceAmount;
+		Material material;
+		unsigned int textureId;
+		// mesh
+		const Mesh* mesh;
+		bool useTextures;
+		glm::mat4 model;
+		// custom
+		int customIndex;
+		bool isPrepassed;	// the depth is in the buffer already
+		bool isOutlined;	// also drawn into the mask of the outlines
+	};
+	// kept over the frames, so they don't allocate after the first ones
+	std::vector<Item> items;
+	std::vector<glm::mat4> instanceData;	// model and normal matrix of every instance
+	std::vector<std::function<void()>> customDraws;
+	std::vector<std::pair<unsigned long long, int>> order;
+
+	glm::vec3 eye = glm::vec3(0);
+	unsigned int instanceVBO = 0;
+	size_t uploadedSize = 0;
+
+	float distanceTo(const glm::vec3& position) const;
+	void addItem(Item& item, float distance);
+
+public:
+	RenderQueue();
+	~RenderQueue();
+
+	void init();
+
+	// drop the items of the last frame, the depth of an item is its distance to the eye
+	void beginFrame(const glm::vec3& eyePosition);
+
+	// the matrices of instances, the first instance returned is for submitInstances() in any pass of the frame
+	int addInstances(const glm::mat4* models, const glm::mat4* normals, int count);
+	// instances of an object drawn by an instance shader (instanceObject.vert layout)
+	void submitInstances(Pass pass, Shader* shader, const Object& object, const Material& material, unsigned int textureId, int firstInstance, int instanceAmount, bool isOutlined = false);
+	// every mesh of a model with the uniform "model", the textures of the meshes are not bound for the shadows
+	// in the depth pass the meshes are drawn from their position only VAO
+	void submitModel(Pass pass, Shader* shader, const Model& model, const glm::mat4& modelMatrix, bool useTextures = true, bool isPrepassed = false);
+	// a draw binding its own state, the queue only binds the shader before it
+	void submitCustom(Pass pass, Shader* shader, const glm::vec3& position, const std::function<void()>& draw, bool isPrepassed = false);
+
+	// sort and draw the items of a pass
+	void flush(Pass pass);
+};
@@ -122,6 +122,9 @@ Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std:
     this->indices = indices;
     this->textures = textures;
 
+    for (unsigned int i = 0; i < vertices.size(); i++)
+        bounds.expand(vertices[i].Position);
+
     // now that we have all the required data, set the vertex buffers and its attribute pointers.
     setupMesh();
 }
@@ -167,38 +170,66 @@ void Mesh::setupMesh()
     // weights
     glEnableVertexAttribArray(6);
     glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
+
+    // the positions packed in a buffer of their own, the depth pre-pass doesn't fetch the rest of the vertex
+    std::vector<glm::vec3> positions(vertices.size());
+    for (unsigned int i = 0; i < vertices.size(); i++)
+        positions[i] = vertices[i].Position;
+    glGenVertexArrays(1, &depthVAO);
+    glGenBuffers(1, &depthVBO);
+    glBindVertexArray(depthVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, depthVBO);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), &positions[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
     glBindVertexArray(0);
 }
 
-void Mesh::Draw(Shader* shader, bool doingShadow)
+void Mesh::bindTextures(Shader* shader) const
 {
     // bind appropriate textures
     unsigned int diffuseNr = 1;
     unsigned int specularNr = 1;
     unsigned int normalNr = 1;
     unsigned int heightNr = 1;
-    if (!doingShadow) {
-        for (unsigned int i = 0; i < textures.size(); i++)
-        {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            std::string number;
-            std::string name = textures[i].type;
-            if (name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
-            else if (name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to string
-            else if (name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to string
-            else if (name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to string
-
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader->ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
-        }
+    for (unsigned int i = 0; i < textures.size(); i++)
+    {
+        glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
+        // retrieve texture number (the N in diffuse_textureN)
+        std::string number;
+        std::string name = textures[i].type;
+        if (name == "texture_diffuse")
+            number = std::to_string(diffuseNr++);
+        else if (name == "texture_specular")
+            number = std::to_string(specularNr++); // transfer unsigned int to string
+        else if (name == "texture_normal")
+            number = std::to_string(normalNr++); // transfer unsigned int to string
+        else if (name == "texture_height")
+            number = std::to_string(heightNr++); // transfer unsigned int to string
+
+        // now set the sampler to the correct texture unit
+        glUniform1i(glGetUniformLocation(shader->ID, (name + number).c_str()), i);
+        // and finally bind the texture
+        glBindTexture(GL_TEXTURE_2D, textures[i].id);
     }
+}
+
+bool Mesh::hasSameTextures(const Mesh& other) const
+{
+    if (textures.size() != other.textures.size())
+        return false;
+    for (unsigned int i = 0; i < textures.size(); i++) {
+        if (textures[i].id != other.textures[i].id || textures[i].type != other.textures[i].type)
+            return false;
+    }
+    return true;
+}
+
+void Mesh::Draw(Shader* shader, bool doingShadow)
+{
+    if (!doingShadow)
+        bindTextures(shader);
 
     // draw mesh
     glBindVertexArray(VAO);
@@ -237,6 +268,7 @@ void Model::processNode(aiNode* node, const aiScene* scene)
     {
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
         meshes.push_back(processMesh(mesh, scene));
+        bounds.expand(meshes.back().bounds);
     }
     // then do the same for each of its children
     for (unsigned int i = 0; i < node->mNumChildren; i++)
@@ -7,6 +7,7 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include "Shader.h"
+#include "Culling.h"
 
 #define MAX_BONE_INFLUENCE 4
 
@@ -122,12 +123,20 @@ public:
     std::vector<Vertex>       vertices;
     std::vector<unsigned int> indices;
     std::vector<Texture>      textures;
+    AABB                      bounds;   // local space, from the vertex positions
 
     Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures);
     void Draw(Shader* shader, bool doingShadow);
+    // bind the textures to their units and samplers of the bound shader
+    void bindTextures(Shader* shader) const;
+    bool hasSameTextures(const Mesh& other) const;
+    unsigned int getVAO() const { return VAO; }
+    // the positions only, for the depth pre-pass
+    unsigned int getDepthVAO() const { return depthVAO; }
 private:
     //  render data
     unsigned int VAO, VBO, EBO;
+    unsigned int depthVAO, depthVBO;
 
     void setupMesh();
 };
@@ -145,6 +154,10 @@ public:
     }
 
     void Draw(Shader* shader, bool doingShadow = false);
+    const std::vector<Mesh>& getMeshes() const { return meshes; }
+
+    // local space bounds of all meshes
+    AABB bounds;
 private:
     // model data 
     std::vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
@@ -4,11 +4,36 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include "ShaderCache.h"
+
+#include <map>
 #include <string>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
+// name of a uniform, from a literal without making a std::string, or from a std::string
+struct UniformName
+{
+    const char* str;
+    UniformName(const char* name) : str(name) {}
+    UniformName(const std::string& name) : str(name.c_str()) {}
+};
+
+// features a shader is compiled with, each one is a #define in the source
+enum ShaderFeature
+{
+    SHADER_USE_IMAGE = 1 << 0,
+    SHADER_USE_MODEL = 1 << 1,
+    SHADER_USE_CROSSHAIR = 1 << 2,
+    SHADER_BULLET_TIME = 1 << 3,
+    SHADER_USE_SPIRAL = 1 << 4,
+    SHADER_USE_IMPACT = 1 << 5,
+    SHADER_USE_SPEED = 1 << 6,
+    SHADER_FEATURE_AMOUNT = 7
+};
+
 class Shader
 {
 public:
@@ -17,57 +42,96 @@ public:
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath)
     {
-        // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-        try
-        {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
-        }
-        catch (std::ifstream::failure& e)
-        {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+        addStage(GL_VERTEX_SHADER, vertexPath, "VERTEX");
+        addStage(GL_FRAGMENT_SHADER, fragmentPath, "FRAGMENT");
+        link();
+    }
+    // constructor with a geometry stage
+    // ------------------------------------------------------------------------
+    Shader(const char* vertexPath, const char* geometryPath, const char* fragmentPath)
+    {
+        addStage(GL_VERTEX_SHADER, vertexPath, "VERTEX");
+        addStage(GL_GEOMETRY_SHADER, geometryPath, "GEOMETRY");
+        addStage(GL_FRAGMENT_SHADER, fragmentPath, "FRAGMENT");
+        link();
+    }
+    // constructor with tessellation control and evaluation stages
+    // ------------------------------------------------------------------------
+    Shader(const char* vertexPath, const char* tessControlPath, const char* tessEvaluationPath, const char* fragmentPath)
+    {
+        addStage(GL_VERTEX_SHADER, vertexPath, "VERTEX");
+        addStage(GL_TESS_CONTROL_SHADER, tessControlPath, "TESS_CONTROL");
+        addStage(GL_TESS_EVALUATION_SHADER, tessEvaluationPath, "TESS_EVALUATION");
+        addStage(GL_FRAGMENT_SHADER, fragmentPath, "FRAGMENT");
+        link();
+    }
+    // constructor of a compute shader
+    // ------------------------------------------------------------------------
+    explicit Shader(const char* computePath)
+    {
+        addStage(GL_COMPUTE_SHADER, computePath, "COMPUTE");
+        link();
+    }
+    // the programs are compiled in the background until this, so the compile overlap with the asset loading
+    // the errors are printed and the new binaries are saved here
+    // ------------------------------------------------------------------------
+    static void finishPending()
+    {
+        std::vector<Shader*>& pending = pendingShaders();
+        while (!pending.empty()) {
+            // with parallel compile take the programs in the order the driver is done with them
+            size_t next = 0;
+            for (size_t i = 0; ShaderCache::isParallel() && i < pending.size(); i++) {
+                int done = 0;
+                glGetProgramiv(pending[i]->ID, GL_COMPLETION_STATUS_KHR, &done);
+                if (done) {
+                    next = i;
+                    break;
+                }
+            }
+            pending[next]->finishLink();
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char* fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessary
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
+    }
+    ~Shader()
+    {
+        finishLink();
+        for (auto& variant : variants)
+            delete variant.second;
+    }
+    // the variants are owned by their root
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+    // the same sources compiled with the ShaderFeature flags and the active light counts, compiled when first asked for
+    // the flags add to the flags of this shader, uniforms set on any of a family are set on all of it
+    // ------------------------------------------------------------------------
+    Shader* variant(unsigned int flags = 0)
+    {
+        if (root != this)
+            return root->variant(features | flags);
+        finishLink();
+        // the light counts only make a difference to the shaders looping over the lights
+        int pointLights = useLights ? activeLights().point : -1;
+        int spotLights = useLights ? activeLights().spot : -1;
+        if (flags == 0 && pointLights < 0 && spotLights < 0)
+            return this;
+        unsigned int key = flags | (unsigned int)(pointLights + 1) << 16 | (unsigned int)(spotLights + 1) << 24;
+        auto found = variants.find(key);
+        if (found != variants.end())
+            return found->second;
+
+        Shader* shader = new Shader(this, flags);
+        shader->link(defines(flags, pointLights, spotLights));
+        shader->finishLink();
+        shader->copyUniforms(*this);
+        variants[key] = shader;
+        return shader;
+    }
+    // the amount of point and spot lights not black, the lit shaders only loop over them
+    // ------------------------------------------------------------------------
+    static void setActiveLights(int pointLights, int spotLights)
+    {
+        activeLights().point = pointLights;
+        activeLights().spot = spotLights;
     }
     // activate the shader
     // ------------------------------------------------------------------------
@@ -77,72 +141,319 @@ public:
     }
     // utility uniform functions
     // ------------------------------------------------------------------------
-    void setBool(const std::string& name, bool value) const
+    void setBool(UniformName name, bool value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+        forEachProgram([&](unsigned int program) { glProgramUniform1i(program, glGetUniformLocation(program, name.str), (int)value); });
     }
     // ------------------------------------------------------------------------
-    void setInt(const std::string& name, int value) const
+    void setInt(UniformName name, int value) const
     {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+        forEachProgram([&](unsigned int program) { glProgramUniform1i(program, glGetUniformLocation(program, name.str), value); });
     }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string& name, float value) const
+    void setFloat(UniformName name, float value) const
     {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+        forEachProgram([&](unsigned int program) { glProgramUniform1f(program, glGetUniformLocation(program, name.str), value); });
     }
     // ------------------------------------------------------------------------
-    void setBlock(const std::string& name, char value) const
+    void setBlock(UniformName name, char value) const
     {
-        glUniformBlockBinding(ID, glGetUniformBlockIndex(ID, name.c_str()), value);
+        forEachProgram([&](unsigned int program) { glUniformBlockBinding(program, glGetUniformBlockIndex(program, name.str), value); });
     }
     // ------------------------------------------------------------------------
-    void setVec2(const std::string& name, const glm::vec2& value) const
+    void setVec2(UniformName name, const glm::vec2& value) const
     {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        forEachProgram([&](unsigned int program) { glProgramUniform2fv(program, glGetUniformLocation(program, name.str), 1, &value[0]); });
     }
-    void setVec2(const std::string& name, float x, float y) const
+    void setVec2(UniformName name, float x, float y) const
     {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+        forEachProgram([&](unsigned int program) { glProgramUniform2f(program, glGetUniformLocation(program, name.str), x, y); });
     }
     // ------------------------------------------------------------------------
-    void setVec3(const std::string& name, const glm::vec3& value) const
+    void setVec3(UniformName name, const glm::vec3& value) const
     {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        forEachProgram([&](unsigned int program) { glProgramUniform3fv(program, glGetUniformLocation(program, name.str), 1, &value[0]); });
     }
-    void setVec3(const std::string& name, float x, float y, float z) const
+    void setVec3(UniformName name, float x, float y, float z) const
     {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+        forEachProgram([&](unsigned int program) { glProgramUniform3f(program, glGetUniformLocation(program, name.str), x, y, z); });
     }
     // ------------------------------------------------------------------------
-    void setVec4(const std::string& name, const glm::vec4& value) const
+    void setVec4(UniformName name, const glm::vec4& value) const
     {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+        forEachProgram([&](unsigned int program) { glProgramUniform4fv(program, glGetUniformLocation(program, name.str), 1, &value[0]); });
     }
-    void setVec4(const std::string& name, float x, float y, float z, float w) const
+    void setVec4(UniformName name, float x, float y, float z, float w) const
     {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+        forEachProgram([&](unsigned int program) { glProgramUniform4f(program, glGetUniformLocation(program, name.str), x, y, z, w); });
     }
     // ------------------------------------------------------------------------
-    void setMat2(const std::string& name, const glm::mat2& mat) const
+    void setMat2(UniformName name, const glm::mat2& mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        forEachProgram([&](unsigned int program) { glProgramUniformMatrix2fv(program, glGetUniformLocation(program, name.str), 1, GL_FALSE, &mat[0][0]); });
     }
     // ------------------------------------------------------------------------
-    void setMat3(const std::string& name, const glm::mat3& mat) const
+    void setMat3(UniformName name, const glm::mat3& mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        forEachProgram([&](unsigned int program) { glProgramUniformMatrix3fv(program, glGetUniformLocation(program, name.str), 1, GL_FALSE, &mat[0][0]); });
     }
     // ------------------------------------------------------------------------
-    void setMat4(const std::string& name, const glm::mat4& mat) const
+    void setMat4(UniformName name, const glm::mat4& mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        forEachProgram([&](unsigned int program) { glProgramUniformMatrix4fv(program, glGetUniformLocation(program, name.str), 1, GL_FALSE, &mat[0][0]); });
     }
 
 private:
+    struct Stage
+    {
+        GLenum type;
+        std::string code;
+        std::string typeName;
+    };
+    struct LightCounts
+    {
+        int point = -1;
+        int spot = -1;
+    };
+
+    // the root of a family keeps the sources and owns the variants
+    Shader* root = this;
+    unsigned int features = 0;
+    std::vector<Stage> stages;
+    bool useLights = false;
+    std::map<unsigned int, Shader*> variants;
+    // the stages compiled but not checked yet, none for a program from the cache
+    std::vector<unsigned int> compiling;
+    std::string cacheKey;
+    bool isPending = false;
+
+    Shader(Shader* rootShader, unsigned int flags) : root(rootShader), features(flags) {}
+
+    static std::vector<Shader*>& pendingShaders()
+    {
+        static std::vector<Shader*> pending;
+        return pending;
+    }
+    static LightCounts& activeLights()
+    {
+        static LightCounts counts;
+        return counts;
+    }
+    // ------------------------------------------------------------------------
+    static std::string defines(unsigned int flags, int pointLights, int spotLights)
+    {
+        static const char* names[SHADER_FEATURE_AMOUNT] = {
+            "USE_IMAGE", "USE_MODEL", "USE_CROSSHAIR", "BULLET_TIME", "USE_SPIRAL", "USE_IMPACT", "USE_SPEED"
+        };
+        std::string result;
+        for (int i = 0; i < SHADER_FEATURE_AMOUNT; i++) {
+            if (flags & (1 << i))
+                result += std::string("#define ") + names[i] + "\n";
+        }
+        if (pointLights >= 0)
+            result += "#define ACTIVE_POINT_LIGHTS " + std::to_string(pointLights) + "\n";
+        if (spotLights >= 0)
+            result += "#define ACTIVE_SPOT_LIGHTS " + std::to_string(spotLights) + "\n";
+        return result;
+    }
+    // the uniforms are set on the root and every variant compiled so far
+    // ------------------------------------------------------------------------
+    template<typename Function>
+    void forEachProgram(Function function) const
+    {
+        function(root->ID);
+        for (auto& variant : root->variants)
+            function(variant.second->ID);
+    }
+    // read one stage from file, with its includes
+    // ------------------------------------------------------------------------
+    void addStage(GLenum type, const char* path, std::string typeName)
+    {
+        std::string code = readFile(path);
+        std::vector<std::string> included;
+        code = resolveIncludes(code, path, 0, included);
+        if (code.find("ACTIVE_POINT_LIGHTS") != std::string::npos || code.find("ACTIVE_SPOT_LIGHTS") != std::string::npos)
+            useLights = true;
+        stages.push_back({ type, code, typeName });
+    }
+    // ------------------------------------------------------------------------
+    static std::string readFile(const std::string& path)
+    {
+        std::string code;
+        std::ifstream file;
+        file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            file.open(path);
+            std::stringstream stream;
+            stream << file.rdbuf();
+            file.close();
+            code = stream.str();
+        }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << " " << e.what() << std::endl;
+        }
+        return code;
+    }
+    // replace the #include "file" lines by the file, the path is relative to the including file
+    // a file is only included once, and #line gives the errors of an included file its own source number
+    // ------------------------------------------------------------------------
+    static std::string resolveIncludes(const std::string& code, const std::string& path, int sourceNumber, std::vector<std::string>& included)
+    {
+        std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+        std::stringstream lines(code);
+        std::string result;
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(lines, line)) {
+            lineNumber++;
+            size_t start = line.find_first_not_of(" \t");
+            size_t open = start != std::string::npos && line.compare(start, 8, "#include") == 0 ? line.find('"', start) : std::string::npos;
+            size_t close = open != std::string::npos ? line.find('"', open + 1) : std::string::npos;
+            if (close == std::string::npos) {
+                result += line + "\n";
+                continue;
+            }
+            std::string includePath = directory + line.substr(open + 1, close - open - 1);
+            bool isIncluded = false;
+            for (const std::string& done : included)
+                isIncluded |= done == includePath;
+            if (!isIncluded) {
+                included.push_back(includePath);
+                int includeNumber = (int)included.size();
+                result += "#line 1 " + std::to_string(includeNumber) + "\n";
+                result += resolveIncludes(readFile(includePath), includePath, includeNumber, included);
+            }
+            result += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceNumber) + "\n";
+        }
+        return result;
+    }
+    // compile the stages of the root with the defines after the #version line, and start linking them
+    // a program in the cache is loaded instead, else it is checked and saved by finishLink()
+    // ------------------------------------------------------------------------
+    void link(const std::string& defineCode = "")
+    {
+        std::vector<std::string> codes;
+        for (const Stage& stage : root->stages) {
+            std::string code = stage.code;
+            if (!defineCode.empty()) {
+                size_t version = code.find("#version");
+                size_t lineEnd = version == std::string::npos ? std::string::npos : code.find('\n', version);
+                // #line keeps the line numbers of the errors the same as the file
+                if (lineEnd != std::string::npos)
+                    code.insert(lineEnd + 1, defineCode + "#line 2\n");
+                else
+                    code = defineCode + code;
+            }
+            codes.push_back(code);
+        }
+        ID = glCreateProgram();
+        cacheKey = ShaderCache::makeKey(codes);
+        if (ShaderCache::load(ID, cacheKey))
+            return;
+
+        for (size_t i = 0; i < codes.size(); i++) {
+            const char* shaderCode = codes[i].c_str();
+            unsigned int shader = glCreateShader(root->stages[i].type);
+            glShaderSource(shader, 1, &shaderCode, NULL);
+            glCompileShader(shader);
+            glAttachShader(ID, shader);
+            compiling.push_back(shader);
+        }
+        glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(ID);
+        isPending = true;
+        pendingShaders().push_back(this);
+    }
+    // wait for the program started by link(), print the errors and save it to the cache
+    // ------------------------------------------------------------------------
+    void finishLink()
+    {
+        if (!isPending)
+            return;
+        isPending = false;
+        std::vector<Shader*>& pending = pendingShaders();
+        for (size_t i = 0; i < pending.size(); i++) {
+            if (pending[i] == this) {
+                pending.erase(pending.begin() + i);
+                break;
+            }
+        }
+        for (size_t i = 0; i < compiling.size(); i++)
+            checkCompileErrors(compiling[i], root->stages[i].typeName);
+        int success = checkCompileErrors(ID, "PROGRAM");
+        // delete the shaders as they're linked into our program now and no longer necessary
+        for (unsigned int shader : compiling)
+            glDeleteShader(shader);
+        compiling.clear();
+        if (success)
+            ShaderCache::save(ID, cacheKey);
+    }
+    // a new variant starts with the uniforms and block bindings already set on the source
+    // ------------------------------------------------------------------------
+    void copyUniforms(const Shader& source)
+    {
+        int amount = 0;
+        char name[256];
+        glGetProgramiv(source.ID, GL_ACTIVE_UNIFORMS, &amount);
+        for (int i = 0; i < amount; i++) {
+            int size;
+            GLenum type;
+            glGetActiveUniform(source.ID, i, sizeof(name), NULL, &size, &type, name);
+            int from = glGetUniformLocation(source.ID, name);
+            int to = glGetUniformLocation(ID, name);
+            if (from < 0 || to < 0)
+                continue;
+            float f[16];
+            int n[4];
+            unsigned int u[4];
+            switch (type) {
+            case GL_FLOAT: glGetUniformfv(source.ID, from, f); glProgramUniform1f(ID, to, f[0]); break;
+            case GL_FLOAT_VEC2: glGetUniformfv(source.ID, from, f); glProgramUniform2fv(ID, to, 1, f); break;
+            case GL_FLOAT_VEC3: glGetUniformfv(source.ID, from, f); glProgramUniform3fv(ID, to, 1, f); break;
+            case GL_FLOAT_VEC4: glGetUniformfv(source.ID, from, f); glProgramUniform4fv(ID, to, 1, f); break;
+            case GL_FLOAT_MAT2: glGetUniformfv(source.ID, from, f); glProgramUniformMatrix2fv(ID, to, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT3: glGetUniformfv(source.ID, from, f); glProgramUniformMatrix3fv(ID, to, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT4: glGetUniformfv(source.ID, from, f); glProgramUniformMatrix4fv(ID, to, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT2x3: glGetUniformfv(source.ID, from, f); glProgramUniformMatrix2x3fv(ID, to, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT2x4: glGetUniformfv(source.ID, from, f); glProgramUniformMatrix2x4fv(ID, to, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT3x2: glGetUniformfv(source.ID, from, f); glProgramUniformMatrix3x2fv(ID, to, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT3x4: glGetUniformfv(source.ID, from, f); glProgramUniformMatrix3x4fv(ID, to, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT4x2: glGetUniformfv(source.ID, from, f); glProgramUniformMatrix4x2fv(ID, to, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT4x3: glGetUniformfv(source.ID, from, f); glProgramUniformMatrix4x3fv(ID, to, 1, GL_FALSE, f); break;
+            case GL_INT_VEC2: case GL_BOOL_VEC2: glGetUniformiv(source.ID, from, n); glProgramUniform2iv(ID, to, 1, n); break;
+            case GL_INT_VEC3: case GL_BOOL_VEC3: glGetUniformiv(source.ID, from, n); glProgramUniform3iv(ID, to, 1, n); break;
+            case GL_INT_VEC4: case GL_BOOL_VEC4: glGetUniformiv(source.ID, from, n); glProgramUniform4iv(ID, to, 1, n); break;
+            case GL_UNSIGNED_INT: glGetUniformuiv(source.ID, from, u); glProgramUniform1ui(ID, to, u[0]); break;
+            case GL_UNSIGNED_INT_VEC2: glGetUniformuiv(source.ID, from, u); glProgramUniform2uiv(ID, to, 1, u); break;
+            case GL_UNSIGNED_INT_VEC3: glGetUniformuiv(source.ID, from, u); glProgramUniform3uiv(ID, to, 1, u); break;
+            case GL_UNSIGNED_INT_VEC4: glGetUniformuiv(source.ID, from, u); glProgramUniform4uiv(ID, to, 1, u); break;
+            // not used by the shaders, and not settable for the atomic counters
+            case GL_DOUBLE: case GL_DOUBLE_VEC2: case GL_DOUBLE_VEC3: case GL_DOUBLE_VEC4:
+            case GL_DOUBLE_MAT2: case GL_DOUBLE_MAT3: case GL_DOUBLE_MAT4:
+            case GL_DOUBLE_MAT2x3: case GL_DOUBLE_MAT2x4: case GL_DOUBLE_MAT3x2:
+            case GL_DOUBLE_MAT3x4: case GL_DOUBLE_MAT4x2: case GL_DOUBLE_MAT4x3:
+            case GL_UNSIGNED_INT_ATOMIC_COUNTER:
+                break;
+            // int, bool and every sampler and image type, the value is one int
+            default:
+                glGetUniformiv(source.ID, from, n); glProgramUniform1i(ID, to, n[0]); break;
+            }
+        }
+        glGetProgramiv(source.ID, GL_ACTIVE_UNIFORM_BLOCKS, &amount);
+        for (int i = 0; i < amount; i++) {
+            int binding;
+            glGetActiveUniformBlockName(source.ID, i, sizeof(name), NULL, name);
+            glGetActiveUniformBlockiv(source.ID, i, GL_UNIFORM_BLOCK_BINDING, &binding);
+            unsigned int index = glGetUniformBlockIndex(ID, name);
+            if (index != GL_INVALID_INDEX)
+                glUniformBlockBinding(ID, index, binding);
+        }
+    }
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
-    void checkCompileErrors(unsigned int shader, std::string type)
+    int checkCompileErrors(unsigned int shader, std::string type)
     {
         int success;
         char infoLog[1024];
@@ -164,6 +475,7 @@ private:
                 std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
             }
         }
+        return success;
     }
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "ShaderCache.h"
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#define CACHE_MAGIC "SRTP"
+
+static std::string cacheDirectory;
+
+static uint64_t hashString(uint64_t hash, const char* data, size_t size) {
+	// FNV-1a
+	for (size_t i = 0; i < size; i++) {
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static std::string pathOf(const std::string& key) {
+	return cacheDirectory + key + ".bin";
+}
+
+void ShaderCache::setDirectory(const std::string& directory) {
+	cacheDirectory = directory;
+	if (cacheDirectory.empty())
+		return;
+	if (cacheDirectory.back() != '/' && cacheDirectory.back() != '\\')
+		cacheDirectory += '/';
+#ifdef _WIN32
+	_mkdir(cacheDirectory.c_str());
+#else
+	mkdir(cacheDirectory.c_str(), 0755);
+#endif
+}
+
+std::string ShaderCache::makeKey(const std::vector<std::string>& sources) {
+	uint64_t hash = 14695981039346656037ull;
+	// the binary only works on the driver that made it
+	const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+	for (GLenum name : driverStrings) {
+		const char* value = (const char*)glGetString(name);
+		if (value != nullptr)
+			hash = hashString(hash, value, strlen(value) + 1);
+	}
+	for (const std::string& source : sources)
+		hash = hashString(hash, source.c_str(), source.size() + 1);
+	char key[17];
+	snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash);
+	return key;
+}
+
+bool ShaderCache::load(unsigned int program, const std::string& key) {
+	if (cacheDirectory.empty())
+		return false;
+	FILE* file = fopen(pathOf(key).c_str(), "rb");
+	if (file == nullptr)
+		return false;
+	char magic[4];
+	GLenum format;
+	int length;
+	std::vector<char> binary;
+	bool isRead = fread(magic, 1, 4, file) == 4 && memcmp(magic, CACHE_MAGIC, 4) == 0
+		&& fread(&format, sizeof(format), 1, file) == 1 && fread(&length, sizeof(length), 1, file) == 1 && length > 0;
+	if (isRead) {
+		binary.resize(length);
+		isRead = fread(binary.data(), 1, length, file) == (size_t)length;
+	}
+	fclose(file);
+	if (!isRead)
+		return false;
+
+	glProgramBinary(program, format, binary.data(), length);
+	int success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	// the driver is free to refuse an old binary, it is made again
+	if (!success)
+		remove(pathOf(key).c_str());
+	return success;
+}
+
+void ShaderCache::save(unsigned int program, const std::string& key) {
+	if (cacheDirectory.empty())
+		return;
+	int length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+	std::vector<char> binary(length);
+	GLenum format;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+
+	FILE* file = fopen(pathOf(key).c_str(), "wb");
+	if (file == nullptr)
+		return;
+	fwrite(CACHE_MAGIC, 1, 4, file);
+	fwrite(&format, sizeof(format), 1, file);
+	fwrite(&length, sizeof(length), 1, file);
+	fwrite(binary.data(), 1, length, file);
+	fclose(file);
+}
+
+bool ShaderCache::isParallel() {
+	// asked once, the extensions don't change with the context
+	static int parallel = -1;
+	if (parallel < 0) {
+		parallel = 0;
+		int amount = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &amount);
+		for (int i = 0; i < amount; i++) {
+			const char* name = (const char*)glGetStringi(GL_EXTENSIONS, i);
+			if (name != nullptr && (strcmp(name, "GL_KHR_parallel_shader_compile") == 0 || strcmp(name, "GL_ARB_parallel_shader_compile") == 0))
+				parallel = 1;
+		}
+	}
+	return parallel == 1;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <glad/glad.h>
+#include <string>
+#include <vector>
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+//program binaries on disk, so a warm start links the programs without compiling GLSL
+//the key is a hash of the sources with the defines and of the driver, a new driver or an edited shader is a miss
+class ShaderCache {
+public:
+	//no directory disables the cache
+	static void setDirectory(const std::string& directory);
+
+	static std::string makeKey(const std::vector<std::string>& sources);
+	//false if there is no binary or the driver refuses it, then the program has to be compiled
+	static bool load(unsigned int program, const std::string& key);
+	//call after the program is linked, it must be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+	static void save(unsigned int program, const std::string& key);
+
+	//KHR_parallel_shader_compile, the driver compiles on its own threads and GL_COMPLETION_STATUS_KHR can be asked without waiting
+	static bool isParallel();
+};
@@ -0,0 +1,211 @@
+#include "ShadowMap.h"
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// the far view distance of every cascade, nothing is shadowed after the last one
+static const float CASCADE_SPLITS[ShadowMap::CASCADE_AMOUNT] = { 150.0f, 600.0f, 2500.0f };
+#define CASTER_DISTANCE 500.0f	// casters out of a cascade on the side of the light, e.g. the pillars over the island
+#define RADIUS_ROUNDING 16.0f	// so the size of a cascade only change with the projection
+#define SNAP_STEPS 4	// steps in a half size of a cascade, its center moves by a step
+#define DEPTH_BIAS_FACTOR 2.0f
+#define DEPTH_BIAS_UNITS 4.0f
+
+static unsigned int makeDepthArray(bool isCompared) {
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT16, ShadowMap::RESOLUTION, ShadowMap::RESOLUTION, ShadowMap::CASCADE_AMOUNT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, isCompared ? GL_LINEAR : GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, isCompared ? GL_LINEAR : GL_NEAREST);
+	// out of a cascade is lit
+	float border[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, border);
+	if (isCompared) {
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	return texture;
+}
+
+static unsigned int makeLayeredFBO(unsigned int texture) {
+	unsigned int fbo;
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		printf("ERROR::FRAMEBUFFER:: Shadow map framebuffer is not complete!\n");
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	return fbo;
+}
+
+ShadowMap::ShadowMap() {
+	params.splits = glm::vec4(0);
+	params.texelSizes = glm::vec4(0);
+	for (int i = 0; i < CASCADE_AMOUNT; i++)
+		params.lightMatrices[i] = glm::mat4(1);
+}
+
+ShadowMap::~ShadowMap() {
+	if (depthFBO != 0)
+		glDeleteFramebuffers(1, &depthFBO);
+	if (staticFBO != 0)
+		glDeleteFramebuffers(1, &staticFBO);
+	if (depthTexture != 0)
+		glDeleteTextures(1, &depthTexture);
+	if (staticTexture != 0)
+		glDeleteTextures(1, &staticTexture);
+	if (paramsUBO != 0)
+		glDeleteBuffers(1, &paramsUBO);
+}
+
+void ShadowMap::init() {
+	depthTexture = makeDepthArray(true);
+	staticTexture = makeDepthArray(false);
+	depthFBO = makeLayeredFBO(depthTexture);
+	staticFBO = makeLayeredFBO(staticTexture);
+
+	glGenBuffers(1, &paramsUBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, paramsUBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(Params), &params, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, SHADOW_BLOCK_BINDING, paramsUBO);
+
+	// no other texture use the unit, it stays bound
+	glActiveTexture(GL_TEXTURE0 + SHADOW_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, depthTexture);
+	glActiveTexture(GL_TEXTURE0);
+	staticValid = false;
+}
+
+void ShadowMap::invalidateStatic() {
+	staticValid = false;
+}
+
+void ShadowMap::update(const glm::vec3& lightPosition, const glm::mat4& view, const glm::mat4& projection, bool enabled) {
+	if (paramsUBO == 0)
+		return;
+	params.splits.w = enabled ? 1.0f : 0.0f;
+	if (enabled) {
+		glm::vec3 direction = glm::normalize(lightPosition);
+		if (direction != lightDirection) {
+			lightDirection = direction;
+			staticValid = false;
+		}
+		glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0, 0, 1) : glm::vec3(0, 1, 0);
+		// only the rotation of the light, the centers are snapped in it
+		glm::mat4 lightRotation = glm::lookAt(glm::vec3(0), -direction, up);
+		glm::mat4 inverseLightRotation = glm::transpose(lightRotation);
+
+		// the corners of the near and far planes in view space, perspective or orthographic
+		glm::mat4 inverseProjection = glm::inverse(projection);
+		glm::mat4 inverseView = glm::inverse(view);
+		glm::vec3 nearCorners[4], farCorners[4];
+		for (int i = 0; i < 4; i++) {
+			float x = (i & 1) ? 1.0f : -1.0f;
+			float y = (i & 2) ? 1.0f : -1.0f;
+			glm::vec4 nearCorner = inverseProjection * glm::vec4(x, y, -1, 1);
+			glm::vec4 farCorner = inverseProjection * glm::vec4(x, y, 1, 1);
+			nearCorners[i] = glm::vec3(nearCorner) / nearCorner.w;
+			farCorners[i] = glm::vec3(farCorner) / farCorner.w;
+		}
+		float nearDistance = -nearCorners[0].z;
+		float farDistance = -farCorners[0].z;
+		float depthRange = std::max(farDistance - nearDistance, 1e-4f);
+
+		float start = nearDistance;
+		for (int c = 0; c < CASCADE_AMOUNT; c++) {
+			float end = std::min(CASCADE_SPLITS[c], farDistance);
+			float from = glm::clamp((start - nearDistance) / depthRange, 0.0f, 1.0f);
+			float to = glm::clamp((end - nearDistance) / depthRange, 0.0f, 1.0f);
+			// bounding sphere of the slice of the frustum, its size doesn't change when the camera turns
+			glm::vec3 corners[8];
+			glm::vec3 center(0);
+			for (int i = 0; i < 4; i++) {
+				corners[i] = glm::vec3(inverseView * glm::vec4(glm::mix(nearCorners[i], farCorners[i], from), 1));
+				corners[i + 4] = glm::vec3(inverseView * glm::vec4(glm::mix(nearCorners[i], farCorners[i], to), 1));
+			}
+			for (const glm::vec3& corner : corners)
+				center += corner / 8.0f;
+			float radius = 0;
+			for (const glm::vec3& corner : corners)
+				radius = std::max(radius, glm::length(corner - center));
+			radius = std::ceil(radius / RADIUS_ROUNDING) * RADIUS_ROUNDING;
+
+			// the half size covers the sphere where ever it is in a step, and a step is whole texels
+			// so the shadows don't swim and the static layer is kept while the camera moves in a step
+			float halfSize = radius * (SNAP_STEPS + 1) / SNAP_STEPS;
+			float step = halfSize / SNAP_STEPS;
+			glm::vec3 lightSpaceCenter = glm::vec3(lightRotation * glm::vec4(center, 1));
+			lightSpaceCenter = glm::floor(lightSpaceCenter / step + 0.5f) * step;
+			if (lightSpaceCenter != cascades[c].center || radius != cascades[c].radius) {
+				cascades[c].center = lightSpaceCenter;
+				cascades[c].radius = radius;
+				staticValid = false;
+			}
+			glm::vec3 snappedCenter = glm::vec3(inverseLightRotation * glm::vec4(lightSpaceCenter, 1));
+
+			glm::mat4 lightView = glm::lookAt(snappedCenter + direction * (halfSize + CASTER_DISTANCE), snappedCenter, up);
+			glm::mat4 lightProjection = glm::ortho(-halfSize, halfSize, -halfSize, halfSize, 0.0f, 2 * halfSize + CASTER_DISTANCE);
+			params.lightMatrices[c] = lightProjection * lightView;
+			casterVolumes[c].update(params.lightMatrices[c]);
+			params.splits[c] = CASCADE_SPLITS[c];
+			params.texelSizes[c] = 2 * halfSize / RESOLUTION;
+			start = end;
+		}
+	}
+
+	glBindBuffer(GL_UNIFORM_BUFFER, paramsUBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Params), &params);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+bool ShadowMap::isCaster(const AABB& box) const {
+	if (params.splits.w == 0)
+		return false;
+	for (int c = 0; c < CASCADE_AMOUNT; c++) {
+		if (casterVolumes[c].isVisible(box))
+			return true;
+	}
+	return false;
+}
+
+void ShadowMap::render(const std::function<void()>& drawStatic, const std::function<void()>& drawMoving) {
+	if (depthFBO == 0 || params.splits.w == 0)
+		return;
+
+	int lastFBO;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &lastFBO);
+	int viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glViewport(0, 0, RESOLUTION, RESOLUTION);
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_TRUE);
+	// slope scaled bias against acne, lighting.glsl also offset the position by the normal
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(DEPTH_BIAS_FACTOR, DEPTH_BIAS_UNITS);
+
+	if (!staticValid) {
+		glBindFramebuffer(GL_FRAMEBUFFER, staticFBO);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		drawStatic();
+		staticValid = true;
+	}
+	// all layers at once
+	glCopyImageSubData(staticTexture, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0,
+		depthTexture, GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0,
+		RESOLUTION, RESOLUTION, CASCADE_AMOUNT);
+	glBindFramebuffer(GL_FRAMEBUFFER, depthFBO);
+	drawMoving();
+
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glBindFramebuffer(GL_FRAMEBUFFER, lastFBO);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <functional>
+#include <glm/glm.hpp>
+#include "Culling.h"
+
+// cascaded shadow map of the main light, sampled by the lit shaders (lighting.glsl)
+// the view distance is cut into CASCADE_AMOUNT ranges, each one is a layer of a depth texture array seen from the light
+// the casters are drawn once into all layers, shadowCascades.geom copies a triangle to every layer
+// the static casters (island, pillars, rails) are kept in a layer of their own, drawn again only when the light,
+// a cascade or the scene changed, and every frame it is copied under the moving casters
+// the parameters are bound to the uniform block "Shadows" (binding 2) of shadows.glsl, the texture to SHADOW_TEXTURE_UNIT
+class ShadowMap {
+public:
+	static const int CASCADE_AMOUNT = 3;	// the same as shadows.glsl
+	static const int RESOLUTION = 2048;
+	static const int SHADOW_BLOCK_BINDING = 2;
+	static const int SHADOW_TEXTURE_UNIT = 7;	// after the units of the model textures
+
+private:
+	// std140 layout of the block Shadows
+	struct Params {
+		glm::mat4 lightMatrices[CASCADE_AMOUNT];
+		glm::vec4 splits;	// the far distance of every cascade, w = 1 if enabled
+		glm::vec4 texelSizes;	// world size of a texel of every cascade
+	};
+	struct Cascade {
+		glm::vec3 center;	// snapped in light space
+		float radius = 0;
+	};
+	Params params;
+	Cascade cascades[CASCADE_AMOUNT];
+	Frustum casterVolumes[CASCADE_AMOUNT];	// the box of every cascade in light space, as far to the light as the casters are drawn
+	glm::vec3 lightDirection = glm::vec3(0);	// from the scene to the light
+	bool staticValid = false;
+
+	unsigned int depthTexture = 0;	// sampled, the static layers plus the moving casters
+	unsigned int staticTexture = 0;
+	unsigned int depthFBO = 0;
+	unsigned int staticFBO = 0;
+	unsigned int paramsUBO = 0;
+
+public:
+	ShadowMap();
+	~ShadowMap();
+
+	void init();
+
+	// the static casters are moved, e.g. the track is edited
+	void invalidateStatic();
+
+	// fit the cascades to the view, the light is a sun in the direction of lightPosition
+	// nothing is sampled when not enabled
+	void update(const glm::vec3& lightPosition, const glm::mat4& view, const glm::mat4& projection, bool enabled);
+
+	// can the box cast a shadow into any cascade, the casters are culled by this instead of the view of the camera
+	// false when not enabled
+	bool isCaster(const AABB& box) const;
+
+	// the callbacks draw the casters with a shader of shadowCascades.geom, the static ones only when they are out of date
+	// call after update(), the frame buffer and the viewport are set back after
+	void render(const std::function<void()>& drawStatic, const std::function<void()>& drawMoving);
+};
@@ -0,0 +1,47 @@
+#include "SpatialHash.h"
+
+SpatialHash::SpatialHash(float cellSize) {
+	this->cellSize = cellSize;
+	minCell = maxCell = Cell{ 0, 0, 0 };
+}
+
+void SpatialHash::build(const Pnt3f* points, int count) {
+	this->points = points;
+	this->count = count;
+
+	// about two buckets for a point, a power of 2 for the mask in bucketOf()
+	int bucketAmount = 16;
+	while (bucketAmount < count * 2)
+		bucketAmount *= 2;
+	bucketStart.assign(bucketAmount + 1, 0);
+	pointCell.resize(count);
+	entries.resize(count);
+
+	for (int i = 0; i < count; i++) {
+		Cell cell = cellOf(points[i]);
+		pointCell[i] = cell;
+		bucketStart[bucketOf(cell)]++;
+		if (i == 0) {
+			minCell = maxCell = cell;
+		}
+		else {
+			minCell.x = std::min(minCell.x, cell.x); maxCell.x = std::max(maxCell.x, cell.x);
+			minCell.y = std::min(minCell.y, cell.y); maxCell.y = std::max(maxCell.y, cell.y);
+			minCell.z = std::min(minCell.z, cell.z); maxCell.z = std::max(maxCell.z, cell.z);
+		}
+	}
+	// the end of every bucket, then fill them from the back so bucketStart become the starts
+	for (int b = 1; b <= bucketAmount; b++)
+		bucketStart[b] += bucketStart[b - 1];
+	for (int i = count - 1; i >= 0; i--)
+		entries[--bucketStart[bucketOf(pointCell[i])]] = i;
+}
+
+SpatialHash::Cell SpatialHash::cellOf(const Pnt3f& p) const {
+	return Cell{ (int)floor(p.x / cellSize), (int)floor(p.y / cellSize), (int)floor(p.z / cellSize) };
+}
+
+int SpatialHash::bucketOf(const Cell& cell) const {
+	unsigned int h = (unsigned int)cell.x * 73856093u ^ (unsigned int)cell.y * 19349663u ^ (unsigned int)cell.z * 83492791u;
+	return (int)(h & (unsigned int)(bucketStart.size() - 2));
+}
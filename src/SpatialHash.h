@@ -0,0 +1,119 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Utilities/Pnt3f.H"
+#include "FrameArena.h"
+
+// uniform grid over points, the cells are hashed into buckets
+// build() is a counting sort of the points by bucket, O(n) and no allocation once the arrays are big enough
+// the points are not copied, they must not change until the next build()
+class SpatialHash {
+public:
+	SpatialHash(float cellSize);
+
+	void build(const Pnt3f* points, int count);
+
+	// call visit(index) once for every point in the cells overlapping the box [min, max]
+	template <class F>
+	void query(Pnt3f min, Pnt3f max, const F& visit) const;
+
+	// the nearest points to center which accept(index), at most maxCount of them, from near to far
+	// the grid is searched ring by ring, so it stops as soon as the nearest ones are sure
+	template <class F>
+	void nearest(Pnt3f center, int maxCount, const F& accept, ArenaVector<int>& result) const;
+
+private:
+	struct Cell {
+		int x, y, z;
+		bool operator==(const Cell& other) const { return x == other.x && y == other.y && z == other.z; }
+	};
+
+	float cellSize;
+	const Pnt3f* points = nullptr;
+	int count = 0;
+	Cell minCell, maxCell;	// bounds of the cells with any point
+
+	std::vector<Cell> pointCell;	// cell of every point
+	std::vector<int> bucketStart;	// entries of bucket b are [bucketStart[b], bucketStart[b + 1])
+	std::vector<int> entries;	// point indices sorted by bucket
+
+	Cell cellOf(const Pnt3f& p) const;
+	int bucketOf(const Cell& cell) const;
+
+	template <class F>
+	void visitCell(const Cell& cell, const F& visit) const;
+};
+
+template <class F>
+void SpatialHash::visitCell(const Cell& cell, const F& visit) const {
+	int bucket = bucketOf(cell);
+	for (int i = bucketStart[bucket]; i < bucketStart[bucket + 1]; i++) {
+		// other cells may share the bucket
+		if (pointCell[entries[i]] == cell)
+			visit(entries[i]);
+	}
+}
+
+template <class F>
+void SpatialHash::query(Pnt3f min, Pnt3f max, const F& visit) const {
+	if (count == 0)
+		return;
+	Cell from = cellOf(min), to = cellOf(max);
+	from.x = std::max(from.x, minCell.x); to.x = std::min(to.x, maxCell.x);
+	from.y = std::max(from.y, minCell.y); to.y = std::min(to.y, maxCell.y);
+	from.z = std::max(from.z, minCell.z); to.z = std::min(to.z, maxCell.z);
+	for (int x = from.x; x <= to.x; x++) {
+		for (int y = from.y; y <= to.y; y++) {
+			for (int z = from.z; z <= to.z; z++)
+				visitCell(Cell{ x, y, z }, visit);
+		}
+	}
+}
+
+template <class F>
+void SpatialHash::nearest(Pnt3f center, int maxCount, const F& accept, ArenaVector<int>& result) const {
+	result.clear();
+	if (count == 0 || maxCount <= 0)
+		return;
+	Cell c = cellOf(center);
+	// after this ring every cell with a point is searched
+	int lastRing = 0;
+	lastRing = std::max(lastRing, std::max(c.x - minCell.x, maxCell.x - c.x));
+	lastRing = std::max(lastRing, std::max(c.y - minCell.y, maxCell.y - c.y));
+	lastRing = std::max(lastRing, std::max(c.z - minCell.z, maxCell.z - c.z));
+
+	ArenaVector<std::pair<float, int>> candidates;	// (squared distance, index)
+	auto addCandidate = [&](int index) {
+		if (!accept(index))
+			return;
+		float dx = points[index].x - center.x, dy = points[index].y - center.y, dz = points[index].z - center.z;
+		candidates.push_back(std::make_pair(dx * dx + dy * dy + dz * dz, index));
+	};
+	for (int ring = 0; ring <= lastRing; ring++) {
+		for (int x = std::max(c.x - ring, minCell.x); x <= std::min(c.x + ring, maxCell.x); x++) {
+			for (int y = std::max(c.y - ring, minCell.y); y <= std::min(c.y + ring, maxCell.y); y++) {
+				// only the shell of the ring, the inside is searched already
+				bool onShell = abs(x - c.x) == ring || abs(y - c.y) == ring;
+				for (int z = std::max(c.z - ring, minCell.z); z <= std::min(c.z + ring, maxCell.z); z++) {
+					if (onShell || abs(z - c.z) == ring)
+						visitCell(Cell{ x, y, z }, addCandidate);
+				}
+			}
+		}
+		// every point closer than ring * cellSize is found now
+		float sure = ring * cellSize;
+		int sureCount = 0;
+		for (auto& candidate : candidates) {
+			if (candidate.first <= sure * sure)
+				sureCount++;
+		}
+		if (sureCount >= maxCount)
+			break;
+	}
+
+	int resultCount = std::min(maxCount, (int)candidates.size());
+	std::partial_sort(candidates.begin(), candidates.begin() + resultCount, candidates.end());
+	for (int i = 0; i < resultCount; i++)
+		result.push_back(candidates[i].second);
+}
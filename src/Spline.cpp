@@ -0,0 +1,81 @@
+#include "Spline.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define SPLINE_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace Spline {
+	void buildSegments(int type, const glm::vec3* pos, const glm::vec3* orient, int amount, Segment* segments) {
+		switch (type) {
+		case LINEAR:
+			buildSegments<LINEAR>(pos, orient, amount, segments);
+			break;
+		case CARDINAL:
+			buildSegments<CARDINAL>(pos, orient, amount, segments);
+			break;
+		default:
+			buildSegments<B_SPLINE>(pos, orient, amount, segments);
+			break;
+		}
+	}
+
+	void getBasisMatrix(int type, float M[16]) {
+		const float* basis = B_SPLINE_BASIS;
+		if (type == LINEAR)
+			basis = LINEAR_BASIS;
+		else if (type == CARDINAL)
+			basis = CARDINAL_BASIS;
+		for (int i = 0; i < 16; i++)
+			M[i] = basis[i];
+	}
+
+#ifdef SPLINE_USE_SSE
+	// value and derivative of one channel at 4 parameters
+	static inline void horner4(const float c[4], __m128 t, __m128& value, __m128& derivative) {
+		__m128 c0 = _mm_set1_ps(c[0]);
+		__m128 c1 = _mm_set1_ps(c[1]);
+		__m128 c2 = _mm_set1_ps(c[2]);
+		__m128 c3 = _mm_set1_ps(c[3]);
+		value = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(c0, t), c1), t), c2), t), c3);
+		__m128 d0 = _mm_mul_ps(c0, _mm_set1_ps(3.0f));
+		__m128 d1 = _mm_mul_ps(c1, _mm_set1_ps(2.0f));
+		derivative = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(d0, t), d1), t), c2);
+	}
+#endif
+
+	void evaluate(const Segment& s, const float* t, int count, glm::vec3* pos, glm::vec3* tangent, glm::vec3* orient) {
+		int i = 0;
+#ifdef SPLINE_USE_SSE
+		alignas(16) float value[4], derivative[4];
+		for (; i + 4 <= count; i += 4) {
+			__m128 T = _mm_loadu_ps(t + i);
+			for (int axis = 0; axis < 3; axis++) {
+				__m128 v, d;
+				horner4(s.pos[axis], T, v, d);
+				_mm_store_ps(value, v);
+				_mm_store_ps(derivative, d);
+				for (int k = 0; k < 4; k++) {
+					pos[i + k][axis] = value[k];
+					tangent[i + k][axis] = derivative[k];
+				}
+				horner4(s.orient[axis], T, v, d);
+				_mm_store_ps(value, v);
+				for (int k = 0; k < 4; k++)
+					orient[i + k][axis] = value[k];
+			}
+		}
+#endif
+		// the rest (or everything without SSE)
+		for (; i < count; i++) {
+			const float u = t[i];
+			for (int axis = 0; axis < 3; axis++) {
+				const float* c = s.pos[axis];
+				pos[i][axis] = ((c[0] * u + c[1]) * u + c[2]) * u + c[3];
+				tangent[i][axis] = (3 * c[0] * u + 2 * c[1]) * u + c[2];
+				const float* o = s.orient[axis];
+				orient[i][axis] = ((o[0] * u + o[1]) * u + o[2]) * u + o[3];
+			}
+		}
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <glm/glm.hpp>
+
+// cubic splines of the track
+// a segment is kept as the coefficients of (t^3, t^2, t, 1), so every spline type is evaluated the same way
+// the spline type only matters when the coefficients are built, and is dispatched once per track build
+namespace Spline {
+	// the same value as TrainWindow::LINEAR, CARDINAL, B_SPLINE
+	enum Type {
+		LINEAR = 1,
+		CARDINAL = 2,
+		B_SPLINE = 3
+	};
+
+	// row j is the weight of control point j on (t^3, t^2, t, 1)
+	constexpr float LINEAR_BASIS[16] = {
+		0, 0, 0, 0,
+		0, 0, -1, 1,
+		0, 0, 1, 0,
+		0, 0, 0, 0
+	};
+	constexpr float CARDINAL_BASIS[16] = {
+		-1 / 2.0f, 2 / 2.0f, -1 / 2.0f, 0,
+		3 / 2.0f, -5 / 2.0f, 0, 2 / 2.0f,
+		-3 / 2.0f, 4 / 2.0f, 1 / 2.0f, 0,
+		1 / 2.0f, -1 / 2.0f, 0, 0
+	};
+	constexpr float B_SPLINE_BASIS[16] = {
+		-1 / 6.0f, 3 / 6.0f, -3 / 6.0f, 1 / 6.0f,
+		3 / 6.0f, -6 / 6.0f, 0, 4 / 6.0f,
+		-3 / 6.0f, 3 / 6.0f, 3 / 6.0f, 1 / 6.0f,
+		1 / 6.0f, 0, 0, 0
+	};
+
+	template <int TYPE> struct Basis;
+	template <> struct Basis<LINEAR> {
+		static constexpr float at(int i) { return LINEAR_BASIS[i]; }
+	};
+	template <> struct Basis<CARDINAL> {
+		static constexpr float at(int i) { return CARDINAL_BASIS[i]; }
+	};
+	template <> struct Basis<B_SPLINE> {
+		static constexpr float at(int i) { return B_SPLINE_BASIS[i]; }
+	};
+
+	// coefficients (t^3, t^2, t, 1) of x, y, z
+	struct Segment {
+		float pos[3][4];
+		float orient[3][4];
+	};
+
+	// segment i start at control point i, and use the points i-1 to i+2 (wrapped)
+	template <int TYPE>
+	void buildSegments(const glm::vec3* pos, const glm::vec3* orient, int amount, Segment* segments) {
+		for (int i = 0; i < amount; i++) {
+			Segment& s = segments[i];
+			for (int axis = 0; axis < 3; axis++) {
+				for (int c = 0; c < 4; c++) {
+					s.pos[axis][c] = 0;
+					s.orient[axis][c] = 0;
+				}
+			}
+			for (int j = 0; j < 4; j++) {
+				const glm::vec3& p = pos[(i + amount - 1 + j) % amount];
+				const glm::vec3& o = orient[(i + amount - 1 + j) % amount];
+				for (int c = 0; c < 4; c++) {
+					// zero weights are folded away by the compiler
+					const float w = Basis<TYPE>::at(j * 4 + c);
+					if (w == 0)
+						continue;
+					for (int axis = 0; axis < 3; axis++) {
+						s.pos[axis][c] += w * p[axis];
+						s.orient[axis][c] += w * o[axis];
+					}
+				}
+			}
+		}
+	}
+
+	// choose the specialisation by the spline type
+	void buildSegments(int type, const glm::vec3* pos, const glm::vec3* orient, int amount, Segment* segments);
+
+	// copy the basis matrix of the spline type, e.g. for a shader uniform
+	void getBasisMatrix(int type, float M[16]);
+
+	// position, tangent (not normalized) and orient at count parameters of one segment
+	// evaluated by Horner's scheme, 4 parameters at a time with SSE
+	void evaluate(const Segment& s, const float* t, int count, glm::vec3* pos, glm::vec3* tangent, glm::vec3* orient);
+}
@@ -0,0 +1,92 @@
+#include "SplineRail.h"
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+#include "TrackTessellator.h"
+#include "RailMesh.h"
+
+const float SplineRail::PIXELS_PER_PIECE = 6.0f;
+
+SplineRail::SplineRail() {
+}
+
+SplineRail::~SplineRail() {
+	clear();
+}
+
+void SplineRail::build(const std::vector<ControlPoint>& points, int splineType) {
+	float M[16];
+	Spline::getBasisMatrix(splineType, M);
+	basis = glm::make_mat4(M);
+
+	// (pos, orient) of the 4 control points of every segment
+	int num_point = (int)points.size();
+	std::vector<glm::vec3> patches;
+	patches.reserve(num_point * 8);
+	for (int i = 0; i < num_point; i++) {
+		for (int j = 0; j < 4; j++) {
+			const ControlPoint& cp = points[(i + num_point - 1 + j) % num_point];
+			patches.push_back(glm::vec3(cp.pos.x, cp.pos.y, cp.pos.z));
+			patches.push_back(glm::vec3(cp.orient.x, cp.orient.y, cp.orient.z));
+		}
+	}
+	vertexAmount = num_point * 4;
+
+	if (VAO == 0) {
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+	}
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, patches.size() * sizeof(glm::vec3), patches.data(), GL_STATIC_DRAW);
+	// Position attribute
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3), (GLvoid*)0);
+	glEnableVertexAttribArray(0);
+	// Orient attribute
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 2 * sizeof(glm::vec3), (GLvoid*)sizeof(glm::vec3));
+	glEnableVertexAttribArray(1);
+	glBindVertexArray(0);
+}
+
+void SplineRail::draw(Shader* shader, const Material& material, const glm::vec2& viewportSize, unsigned int textureId) {
+	if (VAO == 0 || vertexAmount == 0)
+		return;
+
+	glBindVertexArray(VAO);
+	// the variant lit by the active lights only
+	shader = shader->variant();
+	shader->use();
+
+	// material properties
+	shader->setVec3("material.ambient", material.ambient);
+	shader->setVec3("material.diffuse", material.diffuse);
+	shader->setVec3("material.specular", material.specular);
+	shader->setFloat("material.shininess", material.shininess);
+
+	// set texture
+	if (textureId != (unsigned int)-1) {
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, textureId);
+	}
+
+	// spline and level of detail
+	shader->setMat4("basis", basis);
+	shader->setVec2("viewportSize", viewportSize);
+	shader->setFloat("pixelsPerPiece", PIXELS_PER_PIECE);
+	shader->setFloat("maxLevel", (float)MAX_LEVEL);
+	shader->setInt("ringLevel", RING_LEVEL);
+	shader->setFloat("railOffset", TrackTessellator::RAIL_OFFSET);
+	shader->setFloat("railRadius", RailMesh::RAIL_SIZE / 2);
+
+	glPatchParameteri(GL_PATCH_VERTICES, 4);
+	glDrawArraysInstanced(GL_PATCHES, 0, vertexAmount, 2);
+}
+
+void SplineRail::clear() {
+	if (VAO != 0) {
+		glDeleteVertexArrays(1, &VAO);
+		glDeleteBuffers(1, &VBO);
+	}
+	VAO = 0;
+	VBO = 0;
+	vertexAmount = 0;
+}
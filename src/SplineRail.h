@@ -0,0 +1,30 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "RenderUnit/RenderStructure.h"
+#include "RenderUnit/Shader.h"
+#include "ControlPoint.H"
+
+// the rails evaluated on the GPU by the railSpline tessellation shaders
+// every track segment is a patch of its 4 control points, uploaded only when the track changed
+// the subdivision of a segment follow its length on the screen
+class SplineRail {
+public:
+	static const float PIXELS_PER_PIECE;	// screen length of a piece of rail
+	static const int MAX_LEVEL = 64;
+	static const int RING_LEVEL = 8;		// pieces around a rail
+
+	SplineRail();
+	~SplineRail();
+
+	void build(const std::vector<ControlPoint>& points, int splineType);
+	// both rails by one instanced draw, the state is left bound
+	void draw(Shader* shader, const Material& material, const glm::vec2& viewportSize, unsigned int textureId = -1);
+	void clear();
+
+private:
+	unsigned int VAO = 0;
+	unsigned int VBO = 0;
+	int vertexAmount = 0;
+	glm::mat4 basis;
+};
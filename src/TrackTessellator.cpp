@@ -0,0 +1,261 @@
+#include "TrackTessellator.h"
+#include <algorithm>
+#include <cmath>
+#include "MathHelper.h"
+
+#define MIN_SUBDIVIDE_DEPTH 1	// at least 2 pieces a segment
+#define MAX_SUBDIVIDE_DEPTH 10	// at most 1024 pieces a segment
+#define MAX_TURN_COS 0.9848f	// cos(10 degree), the most a piece can bend or twist
+
+const float TrackTessellator::DEFAULT_TOLERANCE = 0.05f;
+const float TrackTessellator::RAIL_OFFSET = 2.5f;
+const float TrackTessellator::SLEEPER_SPACING = 5.0f;
+const float TrackTessellator::PIER_SPACING = 10.5f;
+const float TrackTessellator::PIER_BOTTOM = -100.0f;
+
+TrackTessellator::TrackTessellator() {
+}
+
+bool TrackTessellator::update(const std::vector<ControlPoint>& points, int splineType, float tolerance) {
+	if (!isChanged(points, splineType, tolerance))
+		return false;
+
+	lastPoints.clear();
+	for (size_t i = 0; i < points.size(); i++) {
+		lastPoints.push_back(glm::vec3(points[i].pos.x, points[i].pos.y, points[i].pos.z));
+		lastPoints.push_back(glm::vec3(points[i].orient.x, points[i].orient.y, points[i].orient.z));
+	}
+	lastSplineType = splineType;
+	lastTolerance = tolerance;
+	this->tolerance = tolerance > 0 ? tolerance : DEFAULT_TOLERANCE;
+
+	setSegments(points, splineType);
+
+	samples.clear();
+	totalLength = 0;
+	for (int i = 0; i < (int)segments.size(); i++)
+		tessellateSegment(i);
+	return true;
+}
+
+const std::vector<TrackSample>& TrackTessellator::getSamples() const {
+	return samples;
+}
+
+float TrackTessellator::getTotalLength() const {
+	return totalLength;
+}
+
+int TrackTessellator::getSegmentAmount() const {
+	return (int)segments.size();
+}
+
+TrackSample TrackTessellator::evaluate(int segment, float t) const {
+	TrackSample sample;
+	evaluateBatch(segment, &t, 1, &sample);
+	return sample;
+}
+
+TrackSample TrackTessellator::sampleAtParameter(float u) const {
+	int n = (int)segments.size();
+	if (n == 0)
+		return TrackSample();
+	float base = std::floor(u);
+	int segment = ((int)base % n + n) % n;
+	TrackSample sample = evaluate(segment, u - base);
+
+	// arc length of the sample by the pieces around it
+	auto it = std::upper_bound(samples.begin(), samples.end(), sample, [](const TrackSample& a, const TrackSample& b) {
+		return a.segment < b.segment || (a.segment == b.segment && a.t < b.t);
+	});
+	if (it != samples.begin() && it != samples.end()) {
+		const TrackSample& a = *(it - 1);
+		sample.arcLength = a.arcLength + glm::length(sample.pos - a.pos);
+	}
+	return sample;
+}
+
+TrackSample TrackTessellator::sampleAtArcLength(float s) const {
+	if (segments.empty())
+		return TrackSample();
+	if (samples.size() < 2 || totalLength <= 0)
+		return evaluate(0, 0);
+	s = std::fmod(s, totalLength);
+	if (s < 0)
+		s += totalLength;
+
+	auto it = std::upper_bound(samples.begin(), samples.end(), s, [](float value, const TrackSample& sample) {
+		return value < sample.arcLength;
+	});
+	if (it == samples.begin())
+		it++;
+	if (it == samples.end())
+		it--;
+	const TrackSample& b = *it;
+	const TrackSample& a = *(it - 1);
+
+	// the piece start at t = 1 of the last segment, which is t = 0 of this one
+	float ta = a.segment == b.segment ? a.t : 0.0f;
+	float pieceLength = b.arcLength - a.arcLength;
+	float k = pieceLength > 0 ? (s - a.arcLength) / pieceLength : 0.0f;
+	TrackSample sample = evaluate(b.segment, ta + (b.t - ta) * k);
+	sample.arcLength = s;
+	return sample;
+}
+
+int TrackTessellator::getSleeperAmount() const {
+	return totalLength > 0 ? (int)std::ceil(totalLength / SLEEPER_SPACING) : 0;
+}
+
+int TrackTessellator::getPierAmount() const {
+	return totalLength > 0 ? (int)std::ceil(totalLength / PIER_SPACING) : 0;
+}
+
+glm::mat4 TrackTessellator::getSleeperMatrix(int index) const {
+	TrackSample sleeper = sampleAtArcLength(index * SLEEPER_SPACING);
+	return MathHelper::getTransformMatrix(sleeper.pos, sleeper.front, sleeper.up, glm::vec3(10, 0.5, 2));
+}
+
+int TrackTessellator::getPierMatrices(int index, glm::mat4* out) const {
+	TrackSample pier = sampleAtArcLength(index * PIER_SPACING);
+	glm::vec3 pierFront(pier.front.x, 0, pier.front.z);
+	if (pier.up.y <= 0 || glm::length(pierFront) < 1e-6f)
+		return 0;
+	pierFront = glm::normalize(pierFront);
+	int amount = 0;
+	for (int side = -1; side <= 1; side += 2) {
+		glm::vec3 trackCenter = pier.pos + pier.right * (side * RAIL_OFFSET);
+		glm::vec3 pierCenter = trackCenter;
+		pierCenter.y = (pierCenter.y + PIER_BOTTOM) / 2;
+		out[amount++] = MathHelper::getTransformMatrix(pierCenter, glm::vec3(0, 1, 0), pierFront, glm::vec3(0.4, 0.4, trackCenter.y - PIER_BOTTOM));
+	}
+	return amount;
+}
+
+bool TrackTessellator::isChanged(const std::vector<ControlPoint>& points, int splineType, float tolerance) const {
+	if (splineType != lastSplineType || tolerance != lastTolerance || lastPoints.size() != points.size() * 2)
+		return true;
+	for (size_t i = 0; i < points.size(); i++) {
+		if (lastPoints[i * 2] != glm::vec3(points[i].pos.x, points[i].pos.y, points[i].pos.z) ||
+			lastPoints[i * 2 + 1] != glm::vec3(points[i].orient.x, points[i].orient.y, points[i].orient.z))
+			return true;
+	}
+	return false;
+}
+
+//calculate the coefficients of every segment, the spline type is chosen here once
+void TrackTessellator::setSegments(const std::vector<ControlPoint>& points, int splineType) {
+	int num_point = (int)points.size();
+	std::vector<glm::vec3> pos(num_point), orient(num_point);
+	for (int i = 0; i < num_point; i++) {
+		pos[i] = glm::vec3(points[i].pos.x, points[i].pos.y, points[i].pos.z);
+		orient[i] = glm::vec3(points[i].orient.x, points[i].orient.y, points[i].orient.z);
+	}
+	segments.resize(num_point);
+	if (num_point > 0)
+		Spline::buildSegments(splineType, pos.data(), orient.data(), num_point, segments.data());
+}
+
+void TrackTessellator::evaluateBatch(int segment, const float* t, int count, TrackSample* out) const {
+	const Spline::Segment& s = segments[segment];
+	const int BLOCK = 64;
+	glm::vec3 pos[BLOCK], tangent[BLOCK], orient[BLOCK];
+	for (int first = 0; first < count; first += BLOCK) {
+		int n = std::min(BLOCK, count - first);
+		Spline::evaluate(s, t + first, n, pos, tangent, orient);
+		for (int i = 0; i < n; i++) {
+			TrackSample& sample = out[first + i];
+			sample.segment = segment;
+			sample.t = t[first + i];
+			sample.arcLength = 0;
+			sample.pos = pos[i];
+			sample.front = tangent[i];
+
+			// the tangent vanish at a doubled control point, use the chord around it
+			if (glm::length(sample.front) < 1e-6f) {
+				float around[2] = { std::max(sample.t - 0.01f, 0.0f), std::min(sample.t + 0.01f, 1.0f) };
+				glm::vec3 aroundPos[2], aroundTangent[2], aroundOrient[2];
+				Spline::evaluate(s, around, 2, aroundPos, aroundTangent, aroundOrient);
+				sample.front = aroundPos[1] - aroundPos[0];
+				if (glm::length(sample.front) < 1e-6f)
+					sample.front = glm::vec3(0, 0, 1);
+			}
+			sample.front = glm::normalize(sample.front);
+
+			sample.right = glm::cross(sample.front, orient[i]);
+			if (glm::length(sample.right) < 1e-6f)
+				sample.right = glm::cross(sample.front, glm::vec3(1, 0, 0));
+			sample.right = glm::normalize(sample.right);
+			sample.up = glm::normalize(glm::cross(sample.right, sample.front));
+		}
+	}
+}
+
+// split level by level, the midpoints of all open pieces in a level are evaluated as one batch
+void TrackTessellator::tessellateSegment(int segment) {
+	float ends[2] = { 0, 1 };
+	level.resize(2);
+	evaluateBatch(segment, ends, 2, level.data());
+	pieceDone.assign(1, false);
+
+	for (int depth = 0; depth < MAX_SUBDIVIDE_DEPTH; depth++) {
+		batchT.clear();
+		for (size_t k = 0; k < pieceDone.size(); k++) {
+			if (!pieceDone[k])
+				batchT.push_back((level[k].t + level[k + 1].t) * 0.5f);
+		}
+		if (batchT.empty())
+			break;
+		batchSamples.resize(batchT.size());
+		evaluateBatch(segment, batchT.data(), (int)batchT.size(), batchSamples.data());
+
+		nextLevel.clear();
+		nextPieceDone.clear();
+		size_t mid = 0;
+		for (size_t k = 0; k < pieceDone.size(); k++) {
+			nextLevel.push_back(level[k]);
+			if (pieceDone[k]) {
+				nextPieceDone.push_back(true);
+				continue;
+			}
+			const TrackSample& m = batchSamples[mid++];
+			if (depth < MIN_SUBDIVIDE_DEPTH || needSplit(level[k], m, level[k + 1])) {
+				nextLevel.push_back(m);
+				nextPieceDone.push_back(false);
+				nextPieceDone.push_back(false);
+			}
+			else
+				nextPieceDone.push_back(true);
+		}
+		nextLevel.push_back(level.back());
+		level.swap(nextLevel);
+		pieceDone.swap(nextPieceDone);
+	}
+
+	// t = 0 of this segment is t = 1 of the last one, except for the first segment
+	if (segment == 0) {
+		level[0].arcLength = 0;
+		samples.push_back(level[0]);
+	}
+	for (size_t k = 1; k < level.size(); k++) {
+		totalLength += glm::length(level[k].pos - samples.back().pos);
+		level[k].arcLength = totalLength;
+		samples.push_back(level[k]);
+	}
+}
+
+bool TrackTessellator::needSplit(const TrackSample& a, const TrackSample& mid, const TrackSample& b) const {
+	// chord error of the center line and both rails, so twisting is counted as well as bending
+	for (int side = -1; side <= 1; side++) {
+		float offset = side * RAIL_OFFSET;
+		glm::vec3 pa = a.pos + a.right * offset;
+		glm::vec3 pb = b.pos + b.right * offset;
+		glm::vec3 pm = mid.pos + mid.right * offset;
+		if (glm::length(pm - (pa + pb) * 0.5f) > tolerance)
+			return true;
+	}
+	// an S curve can have its middle on the chord, so limit the turning of a piece too
+	if (glm::dot(a.front, b.front) < MAX_TURN_COS || glm::dot(a.up, b.up) < MAX_TURN_COS)
+		return true;
+	return false;
+}
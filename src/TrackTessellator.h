@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+#include "ControlPoint.H"
+#include "Spline.h"
+
+// one point on the tessellated track
+struct TrackSample {
+	int segment;		// the segment start from this control point
+	float t;			// [0, 1] in the segment
+	glm::vec3 pos;
+	glm::vec3 front;	// unit tangent
+	glm::vec3 up;		// unit, perpendicular to front
+	glm::vec3 right;	// unit, front x up
+	float arcLength;	// from the start of the track
+};
+
+// split the spline segments by curvature and twist until the chord error is under the tolerance
+// the result only depend on the control points, the spline type and the tolerance
+// it is rebuilt only when one of them changed
+class TrackTessellator {
+public:
+	static const float DEFAULT_TOLERANCE;
+	static const float RAIL_OFFSET;	// distance from the center line to a rail
+	// the sleepers and the piers are at i * spacing along the track, the piers stand on PIER_BOTTOM
+	static const float SLEEPER_SPACING;
+	static const float PIER_SPACING;
+	static const float PIER_BOTTOM;
+
+	TrackTessellator();
+
+	// rebuild the samples if the track changed, return true if rebuilt
+	bool update(const std::vector<ControlPoint>& points, int splineType, float tolerance);
+
+	const std::vector<TrackSample>& getSamples() const;
+	float getTotalLength() const;
+	int getSegmentAmount() const;
+
+	// exact point on the curve
+	TrackSample evaluate(int segment, float t) const;
+	// u is segment + t, wrapped into the track
+	TrackSample sampleAtParameter(float u) const;
+	// s is the distance from the start, wrapped into the track
+	TrackSample sampleAtArcLength(float s) const;
+
+	int getSleeperAmount() const;
+	int getPierAmount() const;
+	glm::mat4 getSleeperMatrix(int index) const;
+	// the piers under both rails, none where the track doesn't face up, return how many were written to out
+	int getPierMatrices(int index, glm::mat4* out) const;
+
+private:
+	std::vector<Spline::Segment> segments;
+	std::vector<TrackSample> samples;
+	float totalLength = 0;
+
+	// what the samples were built from
+	std::vector<glm::vec3> lastPoints;
+	int lastSplineType = -1;
+	float lastTolerance = -1;
+	float tolerance = DEFAULT_TOLERANCE;
+
+	// reused by every build
+	std::vector<TrackSample> level;
+	std::vector<TrackSample> nextLevel;
+	std::vector<bool> pieceDone;
+	std::vector<bool> nextPieceDone;
+	std::vector<float> batchT;
+	std::vector<TrackSample> batchSamples;
+
+	bool isChanged(const std::vector<ControlPoint>& points, int splineType, float tolerance) const;
+	void setSegments(const std::vector<ControlPoint>& points, int splineType);
+	// samples at count parameters of one segment
+	void evaluateBatch(int segment, const float* t, int count, TrackSample* out) const;
+	void tessellateSegment(int segment);
+	bool needSplit(const TrackSample& a, const TrackSample& mid, const TrackSample& b) const;
+};
@@ -44,6 +44,12 @@
 #include "Utilities/3DUtils.H"
 
 #include "MathHelper.h"
+#include "JobSystem.h"
+#include "AllocTracker.h"
+#include "Random.h"
+#include "InputRecorder.h"
+#include "FrameCapture.h"
+#include "GLStats.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
@@ -65,8 +71,6 @@
 #define ELLIPTICAL_PARTICLE_FRAG_PATH "assets/shaders/ellipticalParticle.frag"
 #define FRAME_VERT_PATH "assets/shaders/frame.vert"
 #define FRAME_FRAG_PATH "assets/shaders/frame.frag"
-#define WHITELINE_VERT_PATH "assets/shaders/whiteLine.vert"
-#define WHITELINE_FRAG_PATH "assets/shaders/whiteLine.frag"
 #define DRILL_VERT_PATH "assets/shaders/drill.vert"
 #define DRILL_FRAG_PATH "assets/shaders/drill.frag"
 #define SPEEDBG_VERT_PATH "assets/shaders/speedBg.vert"
@@ -74,10 +78,19 @@
 #define INSTANCE_SHADOW_VERT_PATH "assets/shaders/instanceObjectShadow.vert"
 #define MODEL_SHADOW_VERT_PATH "assets/shaders/model_loading_shadow.vert"
 #define OBJ_SHADOW_FRAG_PATH "assets/shaders/simpleObjectshadow.frag"
+#define SHADOW_CASCADES_GEOM_PATH "assets/shaders/shadowCascades.geom"
 #define ISLAND_HEIGHT_VERT_PATH "assets/shaders/islandHeight.vert"
 #define ISLAND_HEIGHT_FRAG_PATH "assets/shaders/islandHeight.frag"
 #define SKYBOX_VERT_PATH "assets/shaders/skyBox.vert"
 #define SKYBOX_FRAG_PATH "assets/shaders/skyBox.frag"
+#define OCCLUSION_BOX_VERT_PATH "assets/shaders/occlusionBox.vert"
+#define OCCLUSION_BOX_FRAG_PATH "assets/shaders/occlusionBox.frag"
+#define RAIL_SPLINE_VERT_PATH "assets/shaders/railSpline.vert"
+#define RAIL_SPLINE_TESC_PATH "assets/shaders/railSpline.tesc"
+#define RAIL_SPLINE_TESE_PATH "assets/shaders/railSpline.tese"
+#define LIGHT_CLUSTERS_COMP_PATH "assets/shaders/lightClusters.comp"
+#define DEPTH_VERT_PATH "assets/shaders/depthOnly.vert"
+#define SHADER_CACHE_PATH "shaderCache/"
 
 //3D models path
 #define WATER_HEIGHT_PATH "assets/images/waterHeight/"
@@ -111,6 +124,19 @@ std::vector<std::string> SKYBOX_PATH = {
 
 #define WATER_RESOLUTION 100
 
+// frustum culling of the track
+#define TRACK_CHUNK_LENGTH 100.0f
+#define TRACK_CHUNK_PADDING 6.0f	// half of the sleeper width plus some space
+#define TRACK_JOB_GRAIN 64	// sleepers or piers in a job
+#define ENTITY_JOB_GRAIN 256	// rockets or fragments in a job
+#define TARGET_CLUSTER_SIZE 100.0f
+#define TARGET_CLUSTER_KEY_BIT (1LL << 62)	// so target keys never meet the chunk index
+
+// the light of an exploded target, fading out in the life (ticks)
+#define EXPLOSION_LIGHT_COLOR glm::vec3(4.0f, 2.2f, 0.8f)
+#define EXPLOSION_LIGHT_RADIUS 60.0f
+#define EXPLOSION_LIGHT_LIFE 40.0f
+
 #define USE_MODEL true
 #define USE_WATER_ANIMATION true
 Assimp::Importer importer;
@@ -128,7 +154,6 @@ TrainView(int x, int y, int w, int h, const char* l)
 
 	resetArcball();
 	freeCamera.setWindow(this);
-	srand(static_cast<unsigned>(time(0)));
 
 	//set the executable file path
 	exePath = getExecutableDir();
@@ -197,6 +222,10 @@ void TrainView::aim(bool draging) {
 
 int TrainView::handle(int event)
 {
+	// the live input is dropped while a recording is replayed
+	if (!InputRecorder::get().onEvent(event))
+		return Fl_Gl_Window::handle(event);
+
 	// see if the ArcBall will handle the event - if it does, 
 	// then we're done
 	// note: the arcball only gets the event if we're in world view
@@ -331,11 +360,12 @@ int TrainView::handle(int event)
 
 //init shader, texture, trainModel, VAO. need called under if(gladLoadGL())
 void TrainView::initRander() {
-	//init shader
+	ALLOC_SCOPE(ALLOC_ASSET_LOADING);
+	//init shader, they compile while the textures load and are finished before the uniform blocks
+	ShaderCache::setDirectory(exePath + SHADER_CACHE_PATH);
 	simpleObjectShader = new Shader((exePath + SIMPLE_OBJECT_VERT_PATH).c_str(), (exePath + SIMPLE_OBJECT_FRAG_PATH).c_str());
 	simpleInstanceObjectShader = new Shader((exePath + INSTANCE_OBJECT_VERT_PATH).c_str(), (exePath + SIMPLE_OBJECT_FRAG_PATH).c_str());
 	pierShader = new Shader((exePath + INSTANCE_OBJECT_VERT_PATH).c_str(), (exePath + PIER_FRAG_PATH).c_str());
-	whiteLineShader = new Shader((exePath + WHITELINE_VERT_PATH).c_str(), (exePath + WHITELINE_FRAG_PATH).c_str());
 	drillShader = new Shader((exePath + DRILL_VERT_PATH).c_str(), (exePath + DRILL_FRAG_PATH).c_str());
 	waterShader = new Shader((exePath + WATER_VERT_PATH).c_str(), (exePath + WATER_FRAG_PATH).c_str());
 	smokeShader = new Shader((exePath + SMOKE_VERT_PATH).c_str(), (exePath + SMOKE_FRAG_PATH).c_str());
@@ -344,10 +374,15 @@ void TrainView::initRander() {
 	ellipticalParticleShader = new Shader((exePath + ELLIPTICAL_PARTICLE_VERT_PATH).c_str(), (exePath + ELLIPTICAL_PARTICLE_FRAG_PATH).c_str());
 	speedBgShader = new Shader((exePath + SPEEDBG_VERT_PATH).c_str(), (exePath + SPEEDBG_FRAG_PATH).c_str());
 	frameShader = new Shader((exePath + FRAME_VERT_PATH).c_str(), (exePath + FRAME_FRAG_PATH).c_str());
-	instanceShadowShader = new Shader((exePath + INSTANCE_SHADOW_VERT_PATH).c_str(), (exePath + OBJ_SHADOW_FRAG_PATH).c_str());
-	modelShadowShader = new Shader((exePath + MODEL_SHADOW_VERT_PATH).c_str(), (exePath + OBJ_SHADOW_FRAG_PATH).c_str());
+	instanceShadowShader = new Shader((exePath + INSTANCE_SHADOW_VERT_PATH).c_str(), (exePath + SHADOW_CASCADES_GEOM_PATH).c_str(), (exePath + OBJ_SHADOW_FRAG_PATH).c_str());
+	modelShadowShader = new Shader((exePath + MODEL_SHADOW_VERT_PATH).c_str(), (exePath + SHADOW_CASCADES_GEOM_PATH).c_str(), (exePath + OBJ_SHADOW_FRAG_PATH).c_str());
 	islandHeightShader = new Shader((exePath + ISLAND_HEIGHT_VERT_PATH).c_str(), (exePath + ISLAND_HEIGHT_FRAG_PATH).c_str());
 	skyboxShader = new Shader((exePath + SKYBOX_VERT_PATH).c_str(), (exePath + SKYBOX_FRAG_PATH).c_str());
+	occlusionBoxShader = new Shader((exePath + OCCLUSION_BOX_VERT_PATH).c_str(), (exePath + OCCLUSION_BOX_FRAG_PATH).c_str());
+	railSplineShader = new Shader((exePath + RAIL_SPLINE_VERT_PATH).c_str(), (exePath + RAIL_SPLINE_TESC_PATH).c_str(), (exePath + RAIL_SPLINE_TESE_PATH).c_str(), (exePath + SIMPLE_OBJECT_FRAG_PATH).c_str());
+	lightClusterShader = new Shader((exePath + LIGHT_CLUSTERS_COMP_PATH).c_str());
+	depthShader = new Shader((exePath + DEPTH_VERT_PATH).c_str(), (exePath + OBJ_SHADOW_FRAG_PATH).c_str());
+	waterDepthShader = new Shader((exePath + WATER_VERT_PATH).c_str(), (exePath + OBJ_SHADOW_FRAG_PATH).c_str());
 
 	//init texture
 	printf("Loading texture...\n");
@@ -377,12 +412,13 @@ void TrainView::initRander() {
 	setObjectTexture("crosshair", "crosshair.png");
 	setObjectTexture("speedBg", "speed_bg.png");
 
+	Shader::finishPending();
+
 	//init unifrom block index
 	//0 for view and project matrix
 	simpleObjectShader->setBlock("Matrices", 0);
 	simpleInstanceObjectShader->setBlock("Matrices", 0);
 	pierShader->setBlock("Matrices", 0);
-	whiteLineShader->setBlock("Matrices", 0);
 	drillShader->setBlock("Matrices", 0);
 	waterShader->setBlock("Matrices", 0);
 	smokeShader->setBlock("Matrices", 0);
@@ -390,10 +426,28 @@ void TrainView::initRander() {
 	particleShader->setBlock("Matrices", 0);
 	ellipticalParticleShader->setBlock("Matrices", 0);
 	speedBgShader->setBlock("Matrices", 0);
-	instanceShadowShader->setBlock("Matrices", 0);
-	modelShadowShader->setBlock("Matrices", 0);
 	islandHeightShader->setBlock("Matrices", 0);
 	skyboxShader->setBlock("Matrices", 0);
+	occlusionBoxShader->setBlock("Matrices", 0);
+	railSplineShader->setBlock("Matrices", 0);
+	depthShader->setBlock("Matrices", 0);
+	waterDepthShader->setBlock("Matrices", 0);
+	//1 for the light clusters, every shader including lighting.glsl
+	Shader* litShaders[] = { simpleObjectShader, simpleInstanceObjectShader, pierShader, waterShader, modelShader, railSplineShader, lightClusterShader };
+	for (Shader* shader : litShaders)
+		shader->setBlock("Clusters", LightClusters::CLUSTER_BLOCK_BINDING);
+	//2 for the shadow map, sampled by the lit shaders and drawn by the shadow shaders
+	Shader* shadowedShaders[] = { simpleObjectShader, simpleInstanceObjectShader, pierShader, waterShader, modelShader, railSplineShader };
+	for (Shader* shader : shadowedShaders) {
+		shader->setBlock("Shadows", ShadowMap::SHADOW_BLOCK_BINDING);
+		shader->setInt("shadowMap", ShadowMap::SHADOW_TEXTURE_UNIT);
+	}
+	instanceShadowShader->setBlock("Shadows", ShadowMap::SHADOW_BLOCK_BINDING);
+	modelShadowShader->setBlock("Shadows", ShadowMap::SHADOW_BLOCK_BINDING);
+
+	// the piers are cut by the height of the island
+	if (USE_MODEL)
+		pierShader = pierShader->variant(SHADER_USE_MODEL);
 
 	//set ubo
 	//0 for view and project matrix
@@ -418,6 +472,11 @@ void TrainView::initRander() {
 	setSkybox();
 	setFBOs();
 	glGenVertexArrays(1, &particle);
+	occlusionCuller.init(occlusionBoxShader, cube);
+	lightClusters.init(lightClusterShader);
+	shadowMap.init();
+	renderQueue.init();
+	dynamicResolution.init();
 
 	// set Model
 	if (USE_MODEL) {
@@ -1188,16 +1247,14 @@ void TrainView::setSmoke()
 
 void TrainView::setFBOs() {
 	glGenFramebuffers(1, &screenFBO);
-	glGenFramebuffers(1, &whiteLineFBO);
 	glGenFramebuffers(1, &islandHeightFBO);
 
 	glGenTextures(1, &screenFrameTexture);
 	glGenTextures(1, &screenDepthTexture);
-	glGenTextures(1, &whiteLineFrameTexture);
+	glGenTextures(1, &screenMaskTexture);
 	glGenTextures(1, &islandHeightTexture);
 
 	glGenRenderbuffers(1, &screenRBO);
-	glGenRenderbuffers(1, &whiteLineRBO);
 	glGenRenderbuffers(1, &islandHeightRBO);
 
 
@@ -1229,11 +1286,16 @@ void TrainView::setFBOs() {
 	frameShader->setInt("screenTexture", 0);
 	frameShader->setInt("crosshairTexture", 1);
 	frameShader->setInt("whiteLineTexture", 2);
-	glUseProgram(0);
 }
 
 void TrainView::setFrameBufferTexture()
 {
+	// always the window size, the scene may be drawn in a part of it
+	if (screenTextureWidth == w() && screenTextureHeight == h())
+		return;
+	screenTextureWidth = w();
+	screenTextureHeight = h();
+
 	glActiveTexture(GL_TEXTURE0);
 
 	glBindTexture(GL_TEXTURE_2D, screenFrameTexture);
@@ -1242,6 +1304,13 @@ void TrainView::setFrameBufferTexture()
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, screenFrameTexture, 0);
 
+	// the mask of the bullet time outlines, drawn by the targets with the scene (RenderQueue)
+	glBindTexture(GL_TEXTURE_2D, screenMaskTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, w(), h(), 0, GL_RED, GL_FLOAT, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, screenMaskTexture, 0);
+
 	glBindRenderbuffer(GL_RENDERBUFFER, screenRBO);
 	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, w(), h());
 	glBindRenderbuffer(GL_RENDERBUFFER, 0);
@@ -1301,6 +1370,11 @@ void TrainView::initLight() {
 //========================================================================
 void TrainView::draw()
 {
+	// everything on the frame arena of the last frame is gone
+	FrameArena::resetAll();
+	ALLOC_BEGIN_FRAME();
+	// feed the input of this frame when replaying
+	InputRecorder::get().onDraw();
 
 	//*********************************************************************
 	//
@@ -1318,6 +1392,9 @@ void TrainView::draw()
 	}
 	else
 		throw std::runtime_error("Could not initialize GLAD!");
+	// count the GL calls of this frame, after gladLoadGL() restored the real functions
+	GLStats::setEnabled(tw->glStats->value());
+	GLStats::beginFrame();
 
 
 
@@ -1325,8 +1402,14 @@ void TrainView::draw()
 	glBindFramebuffer(GL_FRAMEBUFFER, screenFBO);
 	setFrameBufferTexture();
 
+	// the scene is drawn smaller when the GPU doesn't hold the frame time, the frame is timed until the post-process
+	dynamicResolution.setEnabled(tw->dynamicResolution->value());
+	dynamicResolution.beginFrame();
+	sceneWidth = dynamicResolution.scaled(w());
+	sceneHeight = dynamicResolution.scaled(h());
+
 	// Set up the view port
-	glViewport(0, 0, w(), h());
+	glViewport(0, 0, sceneWidth, sceneHeight);
 
 	// clear the window, be sure to clear the Z-Buffer too
 	glClearColor(0, 0, .3f, 0);		// background should be blue
@@ -1336,6 +1419,11 @@ void TrainView::draw()
 	glClearStencil(0);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 	glEnable(GL_DEPTH);
+	// the outline mask is far where no target is drawn, it is only in the second draw buffer of the targets
+	if (RenderDatabase::timeScale == RenderDatabase::BULLET_TIME_SCALE) {
+		const float farMask = 1.0f;
+		glClearTexImage(screenMaskTexture, 0, GL_RED, GL_FLOAT, &farMask);
+	}
 
 	// Blayne prefers GL_DIFFUSE
 	glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
@@ -1384,13 +1472,19 @@ void TrainView::draw()
 	spotLights[0].outerCutOff = cos(MathHelper::degreeToRadians(35));
 	spotLights[0].linear = 0.007;
 	spotLights[0].quadratic = 0.0002;
+	// the lit shaders only loop up to the last light not black
+	int activePointLights = 0, activeSpotLights = 0;
+	for (int i = 0; i < 4; i++) {
+		if (pointLights[i].ambient + pointLights[i].diffuse + pointLights[i].specular != glm::vec3(0, 0, 0))
+			activePointLights = i + 1;
+		if (spotLights[i].ambient + spotLights[i].diffuse + spotLights[i].specular != glm::vec3(0, 0, 0))
+			activeSpotLights = i + 1;
+	}
+	Shader::setActiveLights(activePointLights, activeSpotLights);
 
 	//*********************************************************************
 	// now draw the ground plane
 	//*********************************************************************
-	// set to opengl fixed pipeline(use opengl 1.x draw function)
-	glUseProgram(0);
-
 	setupFloor();
 	//glDisable(GL_LIGHTING);
 	//drawFloor(200, 200);
@@ -1403,24 +1497,16 @@ void TrainView::draw()
 	setupObjects();
 
 	if (USE_MODEL) {
+		GLStats::beginPass("islandHeight");
 		drawIslandHeight();
 		glBindFramebuffer(GL_FRAMEBUFFER, screenFBO);
+		glViewport(0, 0, sceneWidth, sceneHeight);
 		glActiveTexture(GL_TEXTURE0);
 		glBindTexture(GL_TEXTURE_2D, islandHeightTexture);
-		if (tw->drawShadow->value()) {
-			instanceShadowShader->use();
-			instanceShadowShader->setBool("useModel", true);
-			instanceShadowShader->setInt("islandHeight", 0);
-			modelShadowShader->use();
-			modelShadowShader->setBool("useModel", true);
-			modelShadowShader->setInt("islandHeight", 0);
-		}
-		pierShader->use();
-		pierShader->setBool("useModel", true);
 		pierShader->setInt("islandHeight", 0);
-		glUseProgram(0);
 	}
 
+	GLStats::beginPass("scene");
 	drawStuff();
 
 	//draw particle
@@ -1453,9 +1539,16 @@ void TrainView::draw()
 	trainParticle2->setAngle(5);
 	trainParticle2->setParticleSize(1);
 	trainParticle2->setColor(glm::vec3(1, 0.95, 0), glm::vec3(1, 0.75, 0), glm::vec3(1, 0.75, 0), 0.8);
-	particleSystem.draw();
+	{
+		ALLOC_SCOPE(ALLOC_PARTICLES);
+		GLStats::beginPass("particles");
+		particleShader->setFloat("pointScale", dynamicResolution.getScale());
+		ellipticalParticleShader->setFloat("pointScale", dynamicResolution.getScale());
+		particleSystem.draw();
+	}
 
 	breakerStrength *= pow(0.8, RenderDatabase::timeScale);
+	lightClusters.advance(RenderDatabase::timeScale);
 
 	//update animation
 	targetChainExplosionUpdate();
@@ -1470,6 +1563,7 @@ void TrainView::draw()
 
 
 
+	GLStats::beginPass("sky");
 	if (animationFrame >= keyFrame[8]) {
 		drawSpeedBg();
 	}
@@ -1477,11 +1571,17 @@ void TrainView::draw()
 		drawSkybox();
 	}
 
-	if (RenderDatabase::timeScale == RenderDatabase::BULLET_TIME_SCALE)
-		drawWhiteLine();
-
 	// final step, do the post-process
+	GLStats::beginPass("post");
 	drawFrame();
+	dynamicResolution.endFrame();
+	// before the overlay, so the frames are the same with the stats on
+	FrameCapture::get().captureFrame(w(), h());
+
+	GLStats::drawOverlay(w(), h());
+	GLStats::endFrame();
+
+	ALLOC_END_FRAME();
 
 
 }
@@ -1697,6 +1797,7 @@ setProjection()
 
 //set shader uniform, like view, projection, lights...
 void TrainView::setShaders() {
+	ALLOC_SCOPE(ALLOC_SHADER_UNIFORMS);
 	//get view matrix and projection matrix
 	glm::mat4 view;
 	glGetFloatv(GL_MODELVIEW_MATRIX, &view[0][0]);
@@ -1709,8 +1810,17 @@ void TrainView::setShaders() {
 	glBufferSubData(GL_UNIFORM_BUFFER, sizeof(glm::mat4), sizeof(glm::mat4), glm::value_ptr(projection));
 	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
+	viewFrustum.update(projection * view);
+
+	// list the explosion lights of every cluster before the lit shaders use them
+	glm::ivec4 viewport;
+	glGetIntegerv(GL_VIEWPORT, &viewport[0]);
+	lightClusters.update(view, projection, viewport);
+	// the cascades follow the view, the main light is the sun of the shadows
+	shadowMap.update(pointLights[0].position, view, projection, tw->drawShadow->value());
+
 	//set uniform
-	Shader* shaders[] = { simpleObjectShader, simpleInstanceObjectShader, pierShader, waterShader, smokeShader, modelShader, instanceShadowShader };
+	Shader* shaders[] = { simpleObjectShader, simpleInstanceObjectShader, pierShader, waterShader, smokeShader, modelShader, railSplineShader };
 	int size = sizeof(shaders) / sizeof(Shader*);
 	for (int i = 0; i < size; i++) {
 		shaders[i]->use();
@@ -1732,39 +1842,42 @@ void TrainView::setShaders() {
 		shaders[i]->setVec3("eyePosition", eyepos);
 
 		// light properties
+		// the names of array elements are made in a buffer on the stack, not in std::string
+		char nameBuffer[64];
+		auto uniformName = [&nameBuffer](const char* array, int index, const char* member) {
+			snprintf(nameBuffer, sizeof(nameBuffer), "%s[%d].%s", array, index, member);
+			return (const char*)nameBuffer;
+		};
 		shaders[i]->setVec3("dirLight.ambient", dirLight.ambient);
 		shaders[i]->setVec3("dirLight.diffuse", dirLight.diffuse);
 		shaders[i]->setVec3("dirLight.specular", dirLight.specular);
 		shaders[i]->setVec3("dirLight.direction", dirLight.direction);
 		for (int j = 0; j < 4; j++) {
-			shaders[i]->setVec3("pointLights[" + std::to_string(j) + "].ambient", pointLights[j].ambient);
-			shaders[i]->setVec3("pointLights[" + std::to_string(j) + "].diffuse", pointLights[j].diffuse);
-			shaders[i]->setVec3("pointLights[" + std::to_string(j) + "].specular", pointLights[j].specular);
-			shaders[i]->setVec3("pointLights[" + std::to_string(j) + "].position", pointLights[j].position);
-			shaders[i]->setFloat("pointLights[" + std::to_string(j) + "].constant", pointLights[j].constant);
-			shaders[i]->setFloat("pointLights[" + std::to_string(j) + "].linear", pointLights[j].linear);
-			shaders[i]->setFloat("pointLights[" + std::to_string(j) + "].quadratic", pointLights[j].quadratic);
+			shaders[i]->setVec3(uniformName("pointLights", j, "ambient"), pointLights[j].ambient);
+			shaders[i]->setVec3(uniformName("pointLights", j, "diffuse"), pointLights[j].diffuse);
+			shaders[i]->setVec3(uniformName("pointLights", j, "specular"), pointLights[j].specular);
+			shaders[i]->setVec3(uniformName("pointLights", j, "position"), pointLights[j].position);
+			shaders[i]->setFloat(uniformName("pointLights", j, "constant"), pointLights[j].constant);
+			shaders[i]->setFloat(uniformName("pointLights", j, "linear"), pointLights[j].linear);
+			shaders[i]->setFloat(uniformName("pointLights", j, "quadratic"), pointLights[j].quadratic);
 		}
 		for (int j = 0; j < 4; j++) {
-			shaders[i]->setVec3("spotLights[" + std::to_string(j) + "].ambient", spotLights[j].ambient);
-			shaders[i]->setVec3("spotLights[" + std::to_string(j) + "].diffuse", spotLights[j].diffuse);
-			shaders[i]->setVec3("spotLights[" + std::to_string(j) + "].specular", spotLights[j].specular);
-			shaders[i]->setVec3("spotLights[" + std::to_string(j) + "].position", spotLights[j].position);
-			shaders[i]->setVec3("spotLights[" + std::to_string(j) + "].direction", spotLights[j].direction);
-			shaders[i]->setFloat("spotLights[" + std::to_string(j) + "].cutOff", spotLights[j].cutOff);
-			shaders[i]->setFloat("spotLights[" + std::to_string(j) + "].outerCutOff", spotLights[j].outerCutOff);
-			shaders[i]->setFloat("spotLights[" + std::to_string(j) + "].constant", spotLights[j].constant);
-			shaders[i]->setFloat("spotLights[" + std::to_string(j) + "].linear", spotLights[j].linear);
-			shaders[i]->setFloat("spotLights[" + std::to_string(j) + "].quadratic", spotLights[j].quadratic);
+			shaders[i]->setVec3(uniformName("spotLights", j, "ambient"), spotLights[j].ambient);
+			shaders[i]->setVec3(uniformName("spotLights", j, "diffuse"), spotLights[j].diffuse);
+			shaders[i]->setVec3(uniformName("spotLights", j, "specular"), spotLights[j].specular);
+			shaders[i]->setVec3(uniformName("spotLights", j, "position"), spotLights[j].position);
+			shaders[i]->setVec3(uniformName("spotLights", j, "direction"), spotLights[j].direction);
+			shaders[i]->setFloat(uniformName("spotLights", j, "cutOff"), spotLights[j].cutOff);
+			shaders[i]->setFloat(uniformName("spotLights", j, "outerCutOff"), spotLights[j].outerCutOff);
+			shaders[i]->setFloat(uniformName("spotLights", j, "constant"), spotLights[j].constant);
+			shaders[i]->setFloat(uniformName("spotLights", j, "linear"), spotLights[j].linear);
+			shaders[i]->setFloat(uniformName("spotLights", j, "quadratic"), spotLights[j].quadratic);
 		}
 
 		shaders[i]->setFloat("gamma", tw->gamma->value());
 	}
 	skyboxShader->use();
 	skyboxShader->setFloat("gamma", tw->gamma->value());
-
-	//set back to opengl fixed pipeline
-	glUseProgram(0);
 }
 
 void TrainView::setObjectTexture(std::string name, std::string texturePath)
@@ -1788,7 +1901,7 @@ unsigned int TrainView::getObjectTexture(std::string name)
 
 //draw object by simple object shader
 void TrainView::drawSimpleObject(const Object& object, const glm::mat4 model, const Material material) {
-	simpleObjectShader->use();
+	simpleObjectShader->variant()->use();
 
 	simpleObjectShader->setMat4("model", model);
 	simpleObjectShader->setMat4("normalMatrix", glm::transpose(glm::inverse(model)));
@@ -1801,12 +1914,6 @@ void TrainView::drawSimpleObject(const Object& object, const glm::mat4 model, co
 
 	glBindVertexArray(object.VAO);
 	glDrawElements(GL_TRIANGLES, object.element_amount, GL_UNSIGNED_INT, 0);
-
-	//unbind VAO
-	glBindVertexArray(0);
-
-	//unbind shader(switch to fixed pipeline)
-	glUseProgram(0);
 }
 
 //roatateTheta is degree and anticlockwise by +y
@@ -1846,10 +1953,23 @@ drawTree(glm::vec3 pos, float rotateTheta, float treeTrunkWidth, float treeHeigh
 	}
 }
 
-void TrainView::drawWater(glm::vec3 pos, glm::vec3 scale, float rotateTheta) {
+void TrainView::drawWater(glm::vec3 pos, glm::vec3 scale, float rotateTheta, bool depthOnly) {
 	const glm::vec3 UP = glm::vec3(0, 1, 0);
 	const glm::vec3 FRONT = glm::vec3(sin(MathHelper::degreeToRadians(rotateTheta)), 0, -cos(MathHelper::degreeToRadians(rotateTheta)));
 	glm::mat4 model = MathHelper::getTransformMatrix(pos, FRONT, UP, scale);
+	int frameNum = (int)tw->clock_time;
+
+	// the depth pre-pass only needs the waves of the height map
+	if (depthOnly) {
+		waterDepthShader->use();
+		waterDepthShader->setMat4("model", model);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, waterHeightMap[frameNum % 200]);
+		waterDepthShader->setInt("heightMap", 0);
+		glBindVertexArray(water.VAO);
+		glDrawElements(GL_TRIANGLES, water.element_amount, GL_UNSIGNED_INT, 0);
+		return;
+	}
 
 	Material waterMaterial = {
 		RenderDatabase::WATER_COLOR,
@@ -1858,7 +1978,7 @@ void TrainView::drawWater(glm::vec3 pos, glm::vec3 scale, float rotateTheta) {
 		128.0f
 	};
 
-	waterShader->use();
+	waterShader->variant()->use();
 
 	waterShader->setMat4("model", model);
 	waterShader->setMat4("normalMatrix", glm::transpose(glm::inverse(model)));
@@ -1869,8 +1989,6 @@ void TrainView::drawWater(glm::vec3 pos, glm::vec3 scale, float rotateTheta) {
 	waterShader->setVec3("material.specular", waterMaterial.specular);
 	waterShader->setFloat("material.shininess", waterMaterial.shininess);
 
-	int frameNum = (int)tw->clock_time;
-
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, waterHeightMap[frameNum % 200]);
 	waterShader->setInt("heightMap", 0);
@@ -1883,15 +2001,9 @@ void TrainView::drawWater(glm::vec3 pos, glm::vec3 scale, float rotateTheta) {
 
 	glBindVertexArray(water.VAO);
 	glDrawElements(GL_TRIANGLES, water.element_amount, GL_UNSIGNED_INT, 0);
-
-	//unbind VAO
-	glBindVertexArray(0);
-
-	//unbind shader(switch to fixed pipeline)
-	glUseProgram(0);
 }
 
-void TrainView::drawSmoke(const std::vector<glm::vec4>& points)
+void TrainView::drawSmoke(const ArenaVector<glm::vec4>& points)
 {
 	smokeShader->use();
 
@@ -1903,9 +2015,6 @@ void TrainView::drawSmoke(const std::vector<glm::vec4>& points)
 	glDrawArrays(GL_POINTS, 0, points.size());
 	//unbind VAO
 	glBindVertexArray(0);
-
-	//unbind shader(switch to fixed pipeline)
-	glUseProgram(0);
 }
 void TrainView::setSkybox()
 {
@@ -1999,14 +2108,13 @@ void TrainView::drawSpeedBg()
 	glDrawArrays(GL_TRIANGLES, 0, 6);
 
 	glDepthFunc(GL_LESS);
-	glUseProgram(0);
 }
 void TrainView::drawIslandHeight()
 {
 	glBindFramebuffer(GL_FRAMEBUFFER, islandHeightFBO);
 	glBindTexture(GL_TEXTURE_2D, islandHeightTexture);
-	std::vector<float> zeroData(w() * h(), 9999.0f);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, w(), h(), 0, GL_RED, GL_FLOAT, zeroData.data());
+	// no initial data, the glClear below fill it with 9999
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, w(), h(), 0, GL_RED, GL_FLOAT, NULL);
 	GLfloat borderColor[] = { -99999.0f };
 	glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
@@ -2040,56 +2148,6 @@ void TrainView::drawIslandHeight()
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
-void TrainView::drawWhiteLine()
-{
-	glBindFramebuffer(GL_FRAMEBUFFER, whiteLineFBO);
-
-	glViewport(0, 0, w(), h());
-	glClearColor(1, 1, 1, 0);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	glActiveTexture(GL_TEXTURE0);
-
-	glBindTexture(GL_TEXTURE_2D, whiteLineFrameTexture);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, w(), h(), 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, whiteLineFrameTexture, 0);
-
-	glBindRenderbuffer(GL_RENDERBUFFER, whiteLineRBO);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, w(), h());
-	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, whiteLineRBO);
-
-	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-		std::cout << "Framebuffer is not complete!" << std::endl;
-		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	}
-
-	InstanceDrawer targetInstance(RenderDatabase::WHITE_PLASTIC_MATERIAL);
-	for (int i = 0; i < targets.size(); i++) {
-		if (targets[i].state == 0) {
-			glm::mat4 targetModel = MathHelper::getTransformMatrix(
-				targets[i].pos.glmvec3(), targets[i].front.glmvec3(), targets[i].up.glmvec3(),
-				glm::vec3(10, 10, 1));
-			targetInstance.addModelMatrix(targetModel);
-		}
-	}
-	InstanceDrawer targetFragInstance(RenderDatabase::WHITE_PLASTIC_MATERIAL);
-	for (int i = 0; i < targetFrags.size(); i++) {
-		glm::mat4 targetFragModel = MathHelper::getTransformMatrix(
-			targetFrags[i].pos.glmvec3(), targetFrags[i].front.glmvec3(), targetFrags[i].up.glmvec3(),
-			glm::vec3(10, 10, 1));
-		targetFragInstance.addModelMatrix(targetFragModel);
-	}
-
-
-	//I don't know why, but it need clear again.
-	glClearColor(1, 1, 1, 0);
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-	targetInstance.drawByInstance(whiteLineShader, cylinder);
-	targetFragInstance.drawByInstance(whiteLineShader, sector);
-}
 void TrainView::drawFrame()
 {
 	// draw on the default frame
@@ -2097,49 +2155,44 @@ void TrainView::drawFrame()
 	glViewport(0, 0, w(), h());
 	glDisable(GL_DEPTH_TEST);
 	glClear(GL_COLOR_BUFFER_BIT);
-	frameShader->use();
 	glBindVertexArray(frameVAO);
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, screenFrameTexture);
 	//glBindTexture(GL_TEXTURE_2D, islandHeightTexture);
 
+	// the effects are compiled into the variant, so the frame only pays for the ones on
+	unsigned int effects = 0;
 	frameShader->setFloat("frame", tw->clock_time);
+	// the scene and its outline mask are upscaled, the crosshair is in the window size
+	frameShader->setVec2("renderScale", (float)sceneWidth / w(), (float)sceneHeight / h());
 	if (tw->trainCam->value() && animationFrame == 0) {
-		frameShader->setBool("useCrosshair", true);
+		effects |= SHADER_USE_CROSSHAIR;
 		frameShader->setFloat("screenAspectRatio", (float)w() / (float)h());
 		glActiveTexture(GL_TEXTURE1);
 		glBindTexture(GL_TEXTURE_2D, getObjectTexture("crosshair"));
 	}
-	else {
-		frameShader->setBool("useCrosshair", false);
-	}
 	if (RenderDatabase::timeScale == RenderDatabase::BULLET_TIME_SCALE) {
-		frameShader->setBool("bulletTime", true);
+		effects |= SHADER_BULLET_TIME;
 		frameShader->setInt("whiteLineTexture", 2);
 		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, whiteLineFrameTexture);
-	}
-	else {
-		frameShader->setBool("bulletTime", false);
+		glBindTexture(GL_TEXTURE_2D, screenMaskTexture);
 	}
 	static float SpiralstartTime;
 	if (SpiralPower == 2.75) {
 		SpiralstartTime = tw->clock_time;
 	}
 	if (SpiralPower >= 3) {
-		frameShader->setBool("useSpiral", true);
+		effects |= SHADER_USE_SPIRAL;
 		frameShader->setFloat("shineTime", (SpiralstartTime - tw->clock_time) * (SpiralPower / 3));
 	}
 	else {
-		frameShader->setBool("useSpiral", false);
 		frameShader->setFloat("shineTime", 0);
 	}
 	if (animationFrame > 316 && animationFrame < 326) {
-		frameShader->setBool("useImpact", true);
+		effects |= SHADER_USE_IMPACT;
 		frameShader->setFloat("shineTime", animationFrame);
 	}
-	else
-		frameShader->setBool("useImpact", false);
+	frameShader->variant(effects)->use();
 
 	glDrawArrays(GL_TRIANGLES, 0, 6);
 	glActiveTexture(0);
@@ -2147,7 +2200,129 @@ void TrainView::drawFrame()
 
 	glEnable(GL_DEPTH_TEST);
 	glClear(GL_DEPTH_BUFFER_BIT);
-	glUseProgram(0);
+}
+
+//cut the track into chunks of TRACK_CHUNK_LENGTH by arc length and get their bounding box
+//a piece of track is put in every chunk it goes through
+void TrainView::buildTrackChunks()
+{
+	const std::vector<TrackSample>& samples = trackTessellator.getSamples();
+	trackChunkBounds.assign((size_t)(trackTessellator.getTotalLength() / TRACK_CHUNK_LENGTH) + 1, AABB());
+	for (size_t i = 1; i < samples.size(); i++) {
+		size_t first = std::min((size_t)(samples[i - 1].arcLength / TRACK_CHUNK_LENGTH), trackChunkBounds.size() - 1);
+		size_t last = std::min((size_t)(samples[i].arcLength / TRACK_CHUNK_LENGTH), trackChunkBounds.size() - 1);
+		for (size_t chunk = first; chunk <= last; chunk++) {
+			trackChunkBounds[chunk].expand(samples[i - 1].pos);
+			trackChunkBounds[chunk].expand(samples[i].pos);
+		}
+	}
+
+	for (size_t i = 0; i < trackChunkBounds.size(); i++) {
+		if (trackChunkBounds[i].isEmpty())
+			continue;
+		// rails and sleepers are beside the curve, piers go down to the ground
+		trackChunkBounds[i].pad(TRACK_CHUNK_PADDING);
+		trackChunkBounds[i].min.y = std::min(trackChunkBounds[i].min.y, TrackTessellator::PIER_BOTTOM);
+	}
+	trackChunkVisible.assign(trackChunkBounds.size(), true);
+	trackChunkCasting.assign(trackChunkBounds.size(), true);
+	// the rails are cut by the same chunks
+	railMesh.build(samples, TRACK_CHUNK_LENGTH);
+	// the chunk index mean other place now
+	occlusionCuller.clear();
+}
+
+//decide which track chunks and target clusters to draw
+//frustum culling first, then the occlusion query result of last frame if the camera use it
+//the queries are flushed by drawStuff() after the opaque pass, so everything drawn is an occluder
+//the track chunks casting into the shadow map are tested against its cascades instead
+void TrainView::cullTrackAndTargets()
+{
+	bool useOcclusion = tw->useOcclusion();
+	if (useOcclusion)
+		occlusionCuller.beginFrame();
+
+	for (size_t i = 0; i < trackChunkBounds.size(); i++) {
+		trackChunkVisible[i] = viewFrustum.isVisible(trackChunkBounds[i]);
+		if (useOcclusion && trackChunkVisible[i]) {
+			trackChunkVisible[i] = occlusionCuller.isVisible(i);
+			occlusionCuller.query(i, trackChunkBounds[i]);
+		}
+		trackChunkCasting[i] = shadowMap.isCaster(trackChunkBounds[i]);
+	}
+
+	if (!useOcclusion)
+		return;
+
+	// group the targets by a grid, one query for a cluster
+	ArenaVector<std::pair<long long, AABB>> targetBoxes;
+	targetBoxes.reserve(targets.size());
+	for (int i = 0; i < targets.size(); i++) {
+		if (targets.state[i] != 0)
+			continue;
+		AABB box(targets.pos[i].glmvec3(), targets.pos[i].glmvec3());
+		box.pad(10);
+		targetBoxes.push_back(std::make_pair(getTargetClusterKey(targets.pos[i]), box));
+	}
+	std::sort(targetBoxes.begin(), targetBoxes.end(), [](const std::pair<long long, AABB>& a, const std::pair<long long, AABB>& b) {
+		return a.first < b.first;
+	});
+	targetClusterVisible.clear();
+	for (size_t i = 0; i < targetBoxes.size();) {
+		long long key = targetBoxes[i].first;
+		AABB cluster;
+		for (; i < targetBoxes.size() && targetBoxes[i].first == key; i++)
+			cluster.expand(targetBoxes[i].second);
+		bool visible = viewFrustum.isVisible(cluster);
+		if (visible) {
+			visible = occlusionCuller.isVisible(key);
+			occlusionCuller.query(key, cluster);
+		}
+		targetClusterVisible.push_back(std::make_pair(key, visible));
+	}
+}
+
+//is any chunk that the arc length [from, to] go through set
+static bool isTrackPieceIn(const std::vector<bool>& chunks, float from, float to)
+{
+	if (chunks.empty())
+		return true;
+	size_t first = std::min((size_t)(from / TRACK_CHUNK_LENGTH), chunks.size() - 1);
+	size_t last = std::min((size_t)(to / TRACK_CHUNK_LENGTH), chunks.size() - 1);
+	for (size_t i = first; i <= last; i++) {
+		if (chunks[i])
+			return true;
+	}
+	return false;
+}
+
+bool TrainView::isTrackPieceVisible(float from, float to)
+{
+	return isTrackPieceIn(trackChunkVisible, from, to);
+}
+
+bool TrainView::isTrackPieceCasting(float from, float to)
+{
+	return isTrackPieceIn(trackChunkCasting, from, to);
+}
+
+//last culling result of the cluster, true if it was not tested
+bool TrainView::isTargetClusterVisible(long long key)
+{
+	auto it = std::lower_bound(targetClusterVisible.begin(), targetClusterVisible.end(), key, [](const std::pair<long long, bool>& cluster, long long key) {
+		return cluster.first < key;
+	});
+	if (it == targetClusterVisible.end() || it->first != key)
+		return true;
+	return it->second;
+}
+
+long long TrainView::getTargetClusterKey(Pnt3f pos)
+{
+	long long x = (long long)floor(pos.x / TARGET_CLUSTER_SIZE) & 0xFFFFF;
+	long long y = (long long)floor(pos.y / TARGET_CLUSTER_SIZE) & 0xFFFFF;
+	long long z = (long long)floor(pos.z / TARGET_CLUSTER_SIZE) & 0xFFFFF;
+	return TARGET_CLUSTER_KEY_BIT | (x << 40) | (y << 20) | z;
 }
 
 
@@ -2168,11 +2343,14 @@ void TrainView::drawStuff(bool doingShadows)
 {
 	//set up shaders uniform
 	setShaders();
+	renderQueue.beginFrame(eyepos);
 
 	// Draw the control points
 	// don't draw the control points if you're driving 
 	// (otherwise you get sea-sick as you drive through them)
 	if (tw->showControlPoint->value() && (tw->worldCam->value() || tw->topCam->value())) {
+		// they are drawn by the fixed pipeline, the only draws left on it with the axis
+		glUseProgram(0);
 		for (size_t i = 0; i < m_pTrack->points.size(); ++i) {
 			if (!doingShadows) {
 				if (((int)i) != selectedCube)
@@ -2184,364 +2362,159 @@ void TrainView::drawStuff(bool doingShadows)
 		}
 	}
 
-	//draw the floor
-	if (!USE_MODEL) {
-		glm::mat4 floorModel = MathHelper::getTransformMatrix(glm::vec3(0, -0.5, 0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0), glm::vec3(200, 1, 200));
-		drawSimpleObject(cube, floorModel, RenderDatabase::GREEN_PLASTIC_MATERIAL);
-	}
-
-	//draw the tree
-	//drawTree(glm::vec3(0, 0, 0));
-
-	//draw the water
-	drawWater(glm::vec3(0, -120, 0), glm::vec3(2500, 1, 2500));
+	// everything is placed before anything is lit, so the shadow map of this frame is drawn once
+	// and all of the lit shaders sample it
 
-	//draw modle
+	//the static models, only drawn into the shadow map when it moved
+	ArenaVector<std::pair<Model*, glm::mat4>> staticModels;
+	//the models on the train, they ride on the train of the last frame like the camera
+	bool drawCirno = USE_MODEL && (!tw->trainCam->value() || animationFrame > 0);
+	glm::mat4 CirnoModel, tankModel, cannonModel;
 	if (USE_MODEL) {
-		modelShader->use();
-		float modelGamma = log2(tw->gamma->value() * 10) / 4.32193;
-		modelShader->setFloat("gamma", modelGamma);
-
-		//draw island
-		glm::mat4 islandModel = MathHelper::getTransformMatrix(glm::vec3(-150, -280, 170), glm::vec3(1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0.5, 0.5, 0.5));
-		modelShader->setMat4("model", islandModel);
-		island->Draw(modelShader);
-
-		//draw pillar
-		glm::mat4 pillarModel = MathHelper::getTransformMatrix(glm::vec3(0, -2, 0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0), glm::vec3(0.2, 0.2, 0.2));
-		modelShader->setMat4("model", pillarModel);
-		stonePillar->Draw(modelShader);
-
-		//draw pillar section
-		glm::mat4 pillarSectionModel = MathHelper::getTransformMatrix(glm::vec3(20, -8, 0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0), glm::vec3(0.01, 0.01, 0.01));
-		modelShader->setMat4("model", pillarSectionModel);
-		stonePillarSection->Draw(modelShader);
-		//another pillar section
-		pillarSectionModel = MathHelper::getTransformMatrix(glm::vec3(0, -8, 20), glm::vec3(1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0.01, 0.01, 0.01));
-		modelShader->setMat4("model", pillarSectionModel);
-		stonePillarSection->Draw(modelShader);
-
-		//draw red arrow
-		glm::mat4 arrowModel = MathHelper::getTransformMatrix(glm::vec3(20, 14.5, 0), glm::vec3(0, 0, -1), glm::vec3(1, 0, 0), glm::vec3(1.5, 1.5, 1.5));
-		modelShader->setMat4("model", arrowModel);
-		arrow_red->Draw(modelShader);
-
-		//draw blue arrow
-		arrowModel = MathHelper::getTransformMatrix(glm::vec3(0, 14.5, 20), glm::vec3(1, 0, 0), glm::vec3(0, 0, 1), glm::vec3(1.5, 1.5, 1.5));
-		modelShader->setMat4("model", arrowModel);
-		arrow_blue->Draw(modelShader);
+		//island
+		staticModels.push_back(std::make_pair(island, MathHelper::getTransformMatrix(glm::vec3(-150, -280, 170), glm::vec3(1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0.5, 0.5, 0.5))));
+		//pillar
+		staticModels.push_back(std::make_pair(stonePillar, MathHelper::getTransformMatrix(glm::vec3(0, -2, 0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0), glm::vec3(0.2, 0.2, 0.2))));
+		//pillar sections
+		staticModels.push_back(std::make_pair(stonePillarSection, MathHelper::getTransformMatrix(glm::vec3(20, -8, 0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0), glm::vec3(0.01, 0.01, 0.01))));
+		staticModels.push_back(std::make_pair(stonePillarSection, MathHelper::getTransformMatrix(glm::vec3(0, -8, 20), glm::vec3(1, 0, 0), glm::vec3(0, 1, 0), glm::vec3(0.01, 0.01, 0.01))));
+		//red and blue arrow
+		staticModels.push_back(std::make_pair(arrow_red, MathHelper::getTransformMatrix(glm::vec3(20, 14.5, 0), glm::vec3(0, 0, -1), glm::vec3(1, 0, 0), glm::vec3(1.5, 1.5, 1.5))));
+		staticModels.push_back(std::make_pair(arrow_blue, MathHelper::getTransformMatrix(glm::vec3(0, 14.5, 20), glm::vec3(1, 0, 0), glm::vec3(0, 0, 1), glm::vec3(1.5, 1.5, 1.5))));
 
 		//FUMO(fumo)(9)
-		if (!tw->trainCam->value() || animationFrame > 0) {
-			modelShader->setFloat("gamma", modelGamma + 1.12);
-			Pnt3f trainRight = trainFront * trainUp;
-			trainRight.normalize();
-			Pnt3f CirnoFront = trainFront + trainRight * 1.25;
-			CirnoFront.normalize();
-			glm::mat4 CirnoModel = MathHelper::getTransformMatrix((trainPos + trainFront * 3 + trainUp * 8.8 + trainRight * 4).glmvec3(), CirnoFront.glmvec3(), trainUp.glmvec3(), glm::vec3(0.3, 0.3, 0.3));
-			modelShader->setMat4("model", CirnoModel);
-			Cirno->Draw(modelShader);
-			if (tw->drawShadow->value()) {
-				modelShadowShader->use();
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, islandHeightTexture);
-				modelShadowShader->setMat4("model", CirnoModel);
-				modelShadowShader->setBool("useModel", true);
-				modelShadowShader->setInt("islandHeight", 0);
-				Cirno->Draw(modelShadowShader,true);
-				glBindTexture(GL_TEXTURE_2D, 0);
-				modelShader->use();
-			}
-			modelShader->setFloat("gamma", modelGamma);
-		}
-
-		//draw tank
-		glm::mat4 tankModel = MathHelper::getTransformMatrix(trainPos.glmvec3(), -trainFront.glmvec3(), trainUp.glmvec3(), glm::vec3(5, 5, 5));
-		modelShader->setMat4("model", tankModel);
-		tank->Draw(modelShader);
-		if (tw->drawShadow->value()) {
-			modelShadowShader->use();
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, islandHeightTexture);
-			modelShadowShader->setMat4("model", tankModel);
-			modelShadowShader->setBool("useModel", true);
-			modelShadowShader->setInt("islandHeight", 0);
-			tank->Draw(modelShadowShader, true);
-			glBindTexture(GL_TEXTURE_2D, 0);
-			modelShader->use();
-		}
-		//draw cannon 
-		if (tw->trainCam->value()) {
-			glm::mat4 cannonModel = MathHelper::getTransformMatrix(trainPos.glmvec3() + trainUp.glmvec3() * 5.0f + trainFront.glmvec3() * 4.0f, -lookingFront.glmvec3(), lookingUp.glmvec3(), glm::vec3(5, 5, 5));
-			modelShader->setMat4("model", cannonModel);
-			cannon->Draw(modelShader);
-			if (tw->drawShadow->value()) {
-				modelShadowShader->use();
-				modelShadowShader->setMat4("model", cannonModel);
-			}
-		}
-		else {
-			glm::mat4 cannonModel = MathHelper::getTransformMatrix(trainPos.glmvec3() + trainUp.glmvec3() * 3.0f + trainFront.glmvec3() * 4.0f, -trainFront.glmvec3(), trainUp.glmvec3(), glm::vec3(5, 5, 5));
-			modelShader->setMat4("model", cannonModel);
-			cannon->Draw(modelShader);
-			if (tw->drawShadow->value()) {
-				modelShadowShader->use();
-				modelShadowShader->setMat4("model", cannonModel);
-			}
-		}
-		
-		if (tw->drawShadow->value()) {
-			modelShadowShader->use();
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, islandHeightTexture);
-			modelShadowShader->setBool("useModel", true);
-			modelShadowShader->setInt("islandHeight", 0);
-			cannon->Draw(modelShadowShader, true);
-			glBindTexture(GL_TEXTURE_2D, 0);
-			modelShader->use();
-		}
-		glBindVertexArray(0);
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glUseProgram(0);
+		Pnt3f trainRight = trainFront * trainUp;
+		trainRight.normalize();
+		Pnt3f CirnoFront = trainFront + trainRight * 1.25;
+		CirnoFront.normalize();
+		CirnoModel = MathHelper::getTransformMatrix((trainPos + trainFront * 3 + trainUp * 8.8 + trainRight * 4).glmvec3(), CirnoFront.glmvec3(), trainUp.glmvec3(), glm::vec3(0.3, 0.3, 0.3));
+		//tank
+		tankModel = MathHelper::getTransformMatrix(trainPos.glmvec3(), -trainFront.glmvec3(), trainUp.glmvec3(), glm::vec3(5, 5, 5));
+		//cannon
+		if (tw->trainCam->value())
+			cannonModel = MathHelper::getTransformMatrix(trainPos.glmvec3() + trainUp.glmvec3() * 5.0f + trainFront.glmvec3() * 4.0f, -lookingFront.glmvec3(), lookingUp.glmvec3(), glm::vec3(5, 5, 5));
+		else
+			cannonModel = MathHelper::getTransformMatrix(trainPos.glmvec3() + trainUp.glmvec3() * 3.0f + trainFront.glmvec3() * 4.0f, -trainFront.glmvec3(), trainUp.glmvec3(), glm::vec3(5, 5, 5));
 	}
 
-	// draw the track, sleeper, train
+	// the track, sleeper, train
 	Material trainMaterial = {
 		glm::vec3(0.89225f, 0.19225f, 0.19225f),
 		glm::vec3(0.80754f, 0.50754f, 0.50754f),
 		glm::vec3(0.808273f, 0.508273f, 0.508273f),
 		128.0f
 	};
-	InstanceDrawer trackInstance(RenderDatabase::SLIVER_MATERIAL);
 	InstanceDrawer sleeperInstance(RenderDatabase::SLIVER_MATERIAL);
+	InstanceDrawer sleeperShadowInstance(RenderDatabase::SLIVER_MATERIAL);
 	InstanceDrawer pierInstance(RenderDatabase::SLIVER_MATERIAL);
 	InstanceDrawer trainInstance(trainMaterial);
+	InstanceDrawer drillInstance(RenderDatabase::SLIVER_MATERIAL);
+	drillInstance.setTexture(this->getObjectTexture("drillImage"));
 
-	const float track_width = 5;
-	Pnt3f last_sleeper(999, 999, 999);
-	Pnt3f last_pier(999, 999, 999);
-	int num_point = m_pTrack->points.size();
-
-	bool trainDrawed = false;
-	float presentArcLength = 0;
-
-	for (int i = 0; i < num_point; ++i) {
-
-		// pos
-		Pnt3f cp_pos_p0 = m_pTrack->points[(i + num_point - 1) % num_point].pos;
-		Pnt3f cp_pos_p1 = m_pTrack->points[i].pos;
-		Pnt3f cp_pos_p2 = m_pTrack->points[(i + 1) % num_point].pos;
-		Pnt3f cp_pos_p3 = m_pTrack->points[(i + 2) % num_point].pos;
-		// orient
-		Pnt3f cp_orient_p0 = m_pTrack->points[(i + num_point - 1) % num_point].orient;
-		Pnt3f cp_orient_p1 = m_pTrack->points[i].orient;
-		Pnt3f cp_orient_p2 = m_pTrack->points[(i + 1) % num_point].orient;
-		Pnt3f cp_orient_p3 = m_pTrack->points[(i + 2) % num_point].orient;
-
-		float cp_pos_x[4] = { cp_pos_p0.x,cp_pos_p1.x,cp_pos_p2.x,cp_pos_p3.x };
-		float cp_pos_y[4] = { cp_pos_p0.y,cp_pos_p1.y,cp_pos_p2.y,cp_pos_p3.y };
-		float cp_pos_z[4] = { cp_pos_p0.z,cp_pos_p1.z,cp_pos_p2.z,cp_pos_p3.z };
-		float cp_orient_x[4] = { cp_orient_p0.x,cp_orient_p1.x,cp_orient_p2.x,cp_orient_p3.x };
-		float cp_orient_y[4] = { cp_orient_p0.y,cp_orient_p1.y,cp_orient_p2.y,cp_orient_p3.y };
-		float cp_orient_z[4] = { cp_orient_p0.z,cp_orient_p1.z,cp_orient_p2.z,cp_orient_p3.z };
-
-		//dynamic change divide line
-		float DIVIDE_LINE = (MathHelper::distance(cp_pos_p0, cp_pos_p1) + MathHelper::distance(cp_pos_p1, cp_pos_p2) + MathHelper::distance(cp_pos_p2, cp_pos_p3)) * DIVIDE_LINE_SCALE;
-		//printf("%f\n", DIVIDE_LINE);
-
-		float M[16];
-		float linearMatrix[16] = {
-			0,0,0,0,
-			0,0,-1,1,
-			0,0,1,0,
-			0,0,0,0
-		};
-		float cardinalMatrix[16] = {
-			-1,2,-1,0,
-			3,-5,0,2,
-			-3,4,1,0,
-			1,-1,0,0
-		};
-		float bSplineMatrix[16] = {
-			-1,3,-3,1,
-			3,-6,0,4,
-			-3,3,3,1,
-			1,0,0,0
-		};
-		if (tw->splineBrowser->value() == TrainWindow::LINEAR) { //linear
-			std::copy(std::begin(linearMatrix), std::end(linearMatrix), std::begin(M));
-			for (int i = 0; i < 16; i++) {
-				M[i] /= 1.0f;
-			}
-		}
-		else if (tw->splineBrowser->value() == TrainWindow::CARDINAL) { //cardinal
-			std::copy(std::begin(cardinalMatrix), std::end(cardinalMatrix), std::begin(M));
-			for (int i = 0; i < 16; i++) {
-				M[i] /= 2.0f;
-			}
-		}
-		else { // B-spline
-			std::copy(std::begin(bSplineMatrix), std::end(bSplineMatrix), std::begin(M));
-			for (int i = 0; i < 16; i++) {
-				M[i] /= 6.0f;
-			}
+	// the track is tessellated again only when it changed
+	{
+		ALLOC_SCOPE(ALLOC_TRACK_BUILD);
+		if (trackTessellator.update(m_pTrack->points, tw->splineBrowser->value(), tw->trackTolerance->value())) {
+			buildTrackChunks();
+			splineRail.build(m_pTrack->points, tw->splineBrowser->value());
+			// the rails are static casters
+			shadowMap.invalidateStatic();
+		}
+	}
+	// cull the track chunks before any matrix is generated
+	cullTrackAndTargets();
+
+	float totalLength = trackTessellator.getTotalLength();
+
+	//sleepers and piers only depend on the track, they are made on all threads and joined after
+	//sleeper
+	PerThread<InstanceMatrices> sleeperMatrices;
+	PerThread<InstanceMatrices> sleeperShadowMatrices;
+	JobSystem::get().parallelFor(0, trackTessellator.getSleeperAmount(), TRACK_JOB_GRAIN, [&](int first, int last) {
+		InstanceMatrices& out = sleeperMatrices.local();
+		InstanceMatrices& shadowOut = sleeperShadowMatrices.local();
+		for (int i = first; i < last; i++) {
+			float s = i * TrackTessellator::SLEEPER_SPACING;
+			bool isVisible = isTrackPieceVisible(s, s);
+			bool isCasting = isTrackPieceCasting(s, s);
+			if (!isVisible && !isCasting)
+				continue;
+			glm::mat4 matrix = trackTessellator.getSleeperMatrix(i);
+			if (isVisible)
+				out.add(matrix);
+			if (isCasting)
+				shadowOut.add(matrix);
+		}
+	});
+
+	//pier, only under the track which face up
+	PerThread<InstanceMatrices> pierMatrices;
+	JobSystem::get().parallelFor(0, trackTessellator.getPierAmount(), TRACK_JOB_GRAIN, [&](int first, int last) {
+		InstanceMatrices& out = pierMatrices.local();
+		glm::mat4 matrices[2];
+		for (int i = first; i < last; i++) {
+			float s = i * TrackTessellator::PIER_SPACING;
+			if (!isTrackPieceVisible(s, s))
+				continue;
+			int amount = trackTessellator.getPierMatrices(i, matrices);
+			for (int j = 0; j < amount; j++)
+				out.add(matrices[j]);
 		}
-		MathHelper::GxM(cp_pos_x, M);
-		MathHelper::GxM(cp_pos_y, M);
-		MathHelper::GxM(cp_pos_z, M);
-		MathHelper::GxM(cp_orient_x, M);
-		MathHelper::GxM(cp_orient_y, M);
-		MathHelper::GxM(cp_orient_z, M);
-
-		float percent = 1.0f / DIVIDE_LINE;
-		float t = 0;
-		Pnt3f qt(MathHelper::MxT(cp_pos_x, t), MathHelper::MxT(cp_pos_y, t), MathHelper::MxT(cp_pos_z, t));
-
-		bool finalRound = false;
-		while (!finalRound) {
-			Pnt3f qt0 = qt;
-			t += percent;
-			if (t >= 1) {
-				finalRound = true;
-				t = 1;
-			}
-			qt = Pnt3f(MathHelper::MxT(cp_pos_x, t), MathHelper::MxT(cp_pos_y, t), MathHelper::MxT(cp_pos_z, t));
-			Pnt3f qt1 = qt;
-			glLineWidth(1);
-			if (!doingShadows)
-				glColor3ub(32, 32, 64);
-			Pnt3f orient_t(MathHelper::MxT(cp_orient_x, t), MathHelper::MxT(cp_orient_y, t), MathHelper::MxT(cp_orient_z, t));
-			orient_t.normalize();
-			Pnt3f cross_t = ((qt1 + qt0 * -1) * orient_t);
-			cross_t.normalize();
-			cross_t = cross_t * (track_width / 2);
-			//draw track
-			static Pnt3f lastDir(0, -1, 0);
-			static Pnt3f lastUp(0, 0, 1);
-			static Pnt3f lastPos(qt1);
-			Pnt3f difference = qt1 - qt0;
-			Pnt3f trackUp = (cross_t * difference).glmvec3();
-			float remoteness = (qt0 + (-1) * eyepos).len() * 0.2 + 100;
-			float Accuracy = (remoteness) / (remoteness - 1) - 0.01;
-			if ((difference.len2() > 0 && MathHelper::cos(lastDir, difference) < Accuracy || MathHelper::cos(lastUp, cross_t) < Accuracy || (lastPos - qt1).len2() > 10000) || finalRound) {
-				Pnt3f trackCenter1 = (qt1 + lastPos + cross_t * 2) * 0.5f;
-				Pnt3f trackCenter2 = (qt1 + lastPos + cross_t * -2) * 0.5f;
-				Pnt3f trackFront = qt1 - lastPos;
-				glm::mat4 trackModel1 = MathHelper::getTransformMatrix(trackCenter1.glmvec3(), trackFront.glmvec3(), trackUp.glmvec3(), glm::vec3(0.3, 0.3, trackFront.len() + 0.15));
-				glm::mat4 trackModel2 = MathHelper::getTransformMatrix(trackCenter2.glmvec3(), trackFront.glmvec3(), trackUp.glmvec3(), glm::vec3(0.3, 0.3, trackFront.len() + 0.15));
-				trackInstance.addModelMatrix(trackModel1);
-				trackInstance.addModelMatrix(trackModel2);
-				lastDir = difference;
-				lastPos = qt1;
-				lastUp = cross_t;
-			}
+	});
 
-			Pnt3f sleeperDistance = qt1 + (-1 * last_sleeper);
-			Pnt3f pierDistance = qt1 + (-1 * last_pier);
-			bool needToDrawTrain = false;
-			if (sleeperDistance.len() > 5 || finalRound) {
-				//draw sleeper
-				glm::vec3 up = glm::cross(cross_t.glmvec3(), (qt1 + qt0 * -1).glmvec3());
-				glm::mat4 sleeperModel = MathHelper::getTransformMatrix(qt1.glmvec3(), (qt1 + qt0 * -1).glmvec3(), up, glm::vec3(10, 0.5, 2));
-				sleeperInstance.addModelMatrix(sleeperModel);
-				last_sleeper = qt1;
-			}
-			if ((pierDistance.len2() > 111 || finalRound) && trackUp.y > 0) {
-				// draw pier
-				Pnt3f trackCenter1 = (qt0 + qt1 + cross_t * 2) * 0.5f;
-				Pnt3f trackCenter2 = (qt0 + qt1 + cross_t * -2) * 0.5f;
-				Pnt3f pierCenter1 = trackCenter1;
-				Pnt3f pierCenter2 = trackCenter2;
-				pierCenter1.y = pierCenter1.y / 2 - 50;
-				pierCenter2.y = pierCenter2.y / 2 - 50;
-				Pnt3f pierFront = qt1 - qt0;
-				pierFront.y = 0;
-				pierFront.normalize();
-				glm::mat4 pierModel1 = MathHelper::getTransformMatrix(pierCenter1.glmvec3(), glm::vec3(0, 1, 0), pierFront.glmvec3(), glm::vec3(0.4, 0.4, trackCenter1.y + 100));
-				glm::mat4 pierModel2 = MathHelper::getTransformMatrix(pierCenter2.glmvec3(), glm::vec3(0, 1, 0), pierFront.glmvec3(), glm::vec3(0.4, 0.4, trackCenter2.y + 100));
-				pierInstance.addModelMatrix(pierModel1);
-				pierInstance.addModelMatrix(pierModel2);
-				last_pier = qt1;
-			}
-			if (tw->arcLength->value() == false) {
-				if (!trainDrawed && t_time * m_pTrack->points.size() >= i + t && t_time * m_pTrack->points.size() <= i + t + percent)
-					needToDrawTrain = true;
-			}
-			else {
-				presentArcLength += (qt1 + (-1 * qt0)).len();
-				if (!trainDrawed && presentArcLength / totalArcLength >= t_time)
-					needToDrawTrain = true;
-			}
-			if (needToDrawTrain) {
-				trainFront = qt1 + qt0 * -1;
-				trainFront.normalize();
-				trainUp = cross_t * trainFront;
-				trainUp.normalize();
-				trainPos = Pnt3f(qt1 + trainUp * 4);
-				if (animationFrame == 0) {
-					//draw train
-					if (!USE_MODEL && !tw->trainCam->value()) {
-						glm::mat4 trainModel = MathHelper::getTransformMatrix(trainPos.glmvec3(), trainFront.glmvec3(), trainUp.glmvec3(), glm::vec3(6, 8, 10));
-						trainInstance.addModelMatrix(trainModel);
-					}
-				}
-				Pnt3f trainLightPosition = qt1 + trainFront * 5.1 + trainUp * 1;
-				float position2[] = { qt1.x + trainFront.x, qt1.y + trainFront.y, qt1.z + trainFront.z, 1.0f };
-				float direction[] = { trainFront.x,trainFront.y,trainFront.z };
-
-				//update train velocity
-				float heightGradient = (qt1.y - qt0.y) / MathHelper::distance(qt1, qt0);
-				trainVelocity = MathHelper::lerp(trainVelocity, tw->speed->value() - heightGradient * 10, 0.3);
-				if (trainVelocity < tw->speed->value() / 5) trainVelocity = tw->speed->value() / 5;
-				trainDrawed = true;
+	for (int i = 0; i < sleeperMatrices.size(); i++) {
+		sleeperInstance.addModelMatrices(sleeperMatrices[i]);
+		sleeperShadowInstance.addModelMatrices(sleeperShadowMatrices[i]);
+		pierInstance.addModelMatrices(pierMatrices[i]);
+	}
+
+	//place the train
+	if (trackTessellator.getSegmentAmount() > 0) {
+		TrackSample trainSample;
+		if (tw->arcLength->value() == false)
+			trainSample = trackTessellator.sampleAtParameter(t_time * trackTessellator.getSegmentAmount());
+		else
+			trainSample = trackTessellator.sampleAtArcLength(t_time * totalLength);
+		trainFront = Pnt3f(trainSample.front);
+		trainUp = Pnt3f(trainSample.up);
+		trainPos = Pnt3f(trainSample.pos + trainSample.up * 4.0f);
+		if (animationFrame == 0) {
+			//train
+			if (!USE_MODEL && !tw->trainCam->value()) {
+				glm::mat4 trainModel = MathHelper::getTransformMatrix(trainPos.glmvec3(), trainFront.glmvec3(), trainUp.glmvec3(), glm::vec3(6, 8, 10));
+				trainInstance.addModelMatrix(trainModel);
 			}
 		}
+
+		//update train velocity
+		float heightGradient = trainSample.front.y;
+		trainVelocity = MathHelper::lerp(trainVelocity, tw->speed->value() - heightGradient * 10, 0.3);
+		if (trainVelocity < tw->speed->value() / 5) trainVelocity = tw->speed->value() / 5;
 	}
-	totalArcLength = presentArcLength;
+	totalArcLength = totalLength;
 	if (animationFrame > 0) {
-		gigaDrillBreak();
-	}
-	if (USE_MODEL)
-		pierInstance.setTexture(islandHeightTexture);
-	pierInstance.drawByInstance(pierShader, hollowCube, true);
-	if (tw->drawShadow->value()) {
-		trackInstance.drawByInstance(simpleInstanceObjectShader, hollowCube, false);
-		sleeperInstance.drawByInstance(simpleInstanceObjectShader, cube, false);
-		trainInstance.drawByInstance(simpleInstanceObjectShader, cube, false);
-
-		trackInstance.setTexture(islandHeightTexture);
-		trackInstance.drawByInstance(instanceShadowShader, hollowCube);
-		sleeperInstance.setTexture(islandHeightTexture);
-		sleeperInstance.drawByInstance(instanceShadowShader, cube);
-		trainInstance.setTexture(islandHeightTexture);
-		trainInstance.drawByInstance(instanceShadowShader, cube);
-	}
-	else {
-		trackInstance.drawByInstance(simpleInstanceObjectShader, hollowCube);
-		sleeperInstance.drawByInstance(simpleInstanceObjectShader, cube);
-		trainInstance.drawByInstance(simpleInstanceObjectShader, cube);
+		gigaDrillBreak(trainInstance, drillInstance);
 	}
 
-	//draw rockets and targets
+	//rockets and targets
 	InstanceDrawer rocketHeadInstance(RenderDatabase::RUBY_MATERIAL);
 	InstanceDrawer rocketBodyInstance(RenderDatabase::SLIVER_MATERIAL);
 	InstanceDrawer targetInstance(RenderDatabase::WHITE_PLASTIC_MATERIAL);
+	InstanceDrawer targetShadowInstance(RenderDatabase::WHITE_PLASTIC_MATERIAL);
 	InstanceDrawer targetFragInstance(RenderDatabase::WHITE_PLASTIC_MATERIAL);
-	std::vector<glm::vec4> smoke;	// vec4 = (x, y, z, alpha)
+	ArenaVector<glm::vec4> smoke;	// vec4 = (x, y, z, alpha)
 	targetInstance.setTexture(this->getObjectTexture("targetImage"));
 	targetFragInstance.setTexture(this->getObjectTexture("targetImage"));
+	// the bullet time outlines are around the targets
+	bool isBulletTime = RenderDatabase::timeScale == RenderDatabase::BULLET_TIME_SCALE;
+	targetInstance.setOutlined(isBulletTime);
+	targetFragInstance.setOutlined(isBulletTime);
 	updateEntity();
 	collisionJudge();
 	for (int i = 0; i < rockets.size(); i++) {
-		if (rockets[i].state == 0) {
-			glm::mat4 HeadModel = MathHelper::getTransformMatrix(
-				rockets[i].pos.glmvec3(), rockets[i].front.glmvec3(), rockets[i].up.glmvec3(),
-				glm::vec3(4, 4, 3));
-			glm::mat4 BodyModel = MathHelper::getTransformMatrix(
-				(rockets[i].pos + rockets[i].front * -5.5).glmvec3(), rockets[i].front.glmvec3(), rockets[i].up.glmvec3(),
-				glm::vec3(3.5, 3.5, 8));
-			rocketHeadInstance.addModelMatrix(HeadModel);
-			rocketBodyInstance.addModelMatrix(BodyModel);
+		if (rockets.state[i] == 0) {
+			rocketHeadInstance.addModelMatrix(rockets.world[i], rockets.normal[i]);
+			rocketBodyInstance.addModelMatrix(rockets.getBodyMatrix(i));
 
 			// add smoke partical
 			//for (int j = 0; j < 20; j++) {
@@ -2550,70 +2523,176 @@ void TrainView::drawStuff(bool doingShadows)
 			//		smoke.push_back(glm::vec4(smokePos.x, smokePos.y, smokePos.z, (float)(j / 20.0)));
 			//	}
 			//}
-
-			if (smokeGenerator.size() <= i) {
-				smokeGenerator.push_back(particleSystem.addParticleGenerator_pointer(particleShader));
-			}
-			smokeGenerator[i]->setPosition(rockets[i].pos.glmvec3());
-			smokeGenerator[i]->setDirection(-rockets[i].front.glmvec3());
-			smokeGenerator[i]->setParticleLife(10);
-			smokeGenerator[i]->setGenerateRate(20);
-			smokeGenerator[i]->setGravity(0);
-			smokeGenerator[i]->setParticleVelocityRandomOffset(0.5);
-			smokeGenerator[i]->setParticleVelocity(1);
-			smokeGenerator[i]->setAngle(40);
-			smokeGenerator[i]->setParticleSize(0.6);
-			smokeGenerator[i]->setColor(glm::vec3(1.0, 1.0, 0.0), glm::vec3(1.0, 0.0, 0.0), glm::vec3(0.5, 0.5, 0.5), 0.5);
-		}
-	}for (int i = rockets.size(); i < smokeGenerator.size(); i++) {
-		smokeGenerator[i]->setGenerateRate(0);
-	}
-	if (tw->drawShadow->value()) {
-		rocketHeadInstance.drawByInstance(simpleInstanceObjectShader, cone, false);
-		rocketBodyInstance.drawByInstance(simpleInstanceObjectShader, cylinder, false);
-		rocketHeadInstance.setTexture(islandHeightTexture);
-		rocketBodyInstance.setTexture(islandHeightTexture);
-		rocketHeadInstance.drawByInstance(instanceShadowShader, cone);
-		rocketBodyInstance.drawByInstance(instanceShadowShader, cylinder);
+		}
 	}
-	else {
-		rocketHeadInstance.drawByInstance(simpleInstanceObjectShader, cone);
-		rocketBodyInstance.drawByInstance(simpleInstanceObjectShader, cylinder);
+	// the rockets are swapped around when one is removed, so a generator finds its rocket by the handle
+	for (size_t i = 0; i < smokeGenerator.size(); i++) {
+		int rocketID = rockets.indexOf(smokeRocket[i]);
+		if (rocketID == -1 || rockets.state[rocketID] != 0) {
+			smokeGenerator[i]->setGenerateRate(0);
+			continue;
+		}
+		smokeGenerator[i]->setPosition(rockets.pos[rocketID].glmvec3());
+		smokeGenerator[i]->setDirection(-rockets.front[rocketID].glmvec3());
+		smokeGenerator[i]->setParticleLife(10);
+		smokeGenerator[i]->setGenerateRate(20);
+		smokeGenerator[i]->setGravity(0);
+		smokeGenerator[i]->setParticleVelocityRandomOffset(0.5);
+		smokeGenerator[i]->setParticleVelocity(1);
+		smokeGenerator[i]->setAngle(40);
+		smokeGenerator[i]->setParticleSize(0.6);
+		smokeGenerator[i]->setColor(glm::vec3(1.0, 1.0, 0.0), glm::vec3(1.0, 0.0, 0.0), glm::vec3(0.5, 0.5, 0.5), 0.5);
 	}
 	//if (smoke.size() > 0)
 	//	drawSmoke(smoke);
 
+	bool useOcclusion = tw->useOcclusion();
 	for (int i = 0; i < targets.size(); i++) {
-		if (targets[i].state == 0) {
-			glm::mat4 targetModel = MathHelper::getTransformMatrix(
-				targets[i].pos.glmvec3(), targets[i].front.glmvec3(), targets[i].up.glmvec3(),
-				glm::vec3(10, 10, 1));
-			targetInstance.addModelMatrix(targetModel);
+		if (targets.state[i] == 0) {
+			// a target hidden from the camera can still cast a shadow on the screen
+			AABB box(targets.pos[i].glmvec3(), targets.pos[i].glmvec3());
+			box.pad(10);
+			if (shadowMap.isCaster(box))
+				targetShadowInstance.addModelMatrix(targets.world[i], targets.normal[i]);
+			if (useOcclusion) {
+				if (!isTargetClusterVisible(getTargetClusterKey(targets.pos[i])))
+					continue;
+			}
+			targetInstance.addModelMatrix(targets.world[i], targets.normal[i]);
 		}
 	}
-	if (tw->drawShadow->value()) {
-		targetInstance.drawByInstance(simpleInstanceObjectShader, cylinder, false);
-		targetInstance.setTexture(islandHeightTexture);
-		targetInstance.drawByInstance(instanceShadowShader, cylinder);
+	targetFragInstance.addModelMatrices(targetFrags.world.data(), targetFrags.normal.data(), targetFrags.size());
+
+	// everything is submitted to the render queue, it sorts the draws of a pass by their state
+	// the shadow casters, the static ones are only drawn when the shadow map moved
+	// the rails of every chunk, they only move with the track
+	renderQueue.submitCustom(RenderQueue::PASS_SHADOW_STATIC, instanceShadowShader->variant(), glm::vec3(0), [&]() {
+		railMesh.draw(instanceShadowShader, RenderDatabase::SLIVER_MATERIAL, std::vector<bool>());
+	});
+	if (USE_MODEL) {
+		for (const auto& model : staticModels)
+			renderQueue.submitModel(RenderQueue::PASS_SHADOW_STATIC, modelShadowShader, *model.first, model.second, false);
+	}
+	sleeperShadowInstance.submit(renderQueue, RenderQueue::PASS_SHADOW, instanceShadowShader, cube);
+	trainInstance.submit(renderQueue, RenderQueue::PASS_SHADOW, instanceShadowShader, cube);
+	drillInstance.submit(renderQueue, RenderQueue::PASS_SHADOW, instanceShadowShader, cone);
+	rocketHeadInstance.submit(renderQueue, RenderQueue::PASS_SHADOW, instanceShadowShader, cone);
+	rocketBodyInstance.submit(renderQueue, RenderQueue::PASS_SHADOW, instanceShadowShader, cylinder);
+	targetShadowInstance.submit(renderQueue, RenderQueue::PASS_SHADOW, instanceShadowShader, cylinder);
+	targetFragInstance.submit(renderQueue, RenderQueue::PASS_SHADOW, instanceShadowShader, sector);
+	if (USE_MODEL) {
+		if (drawCirno)
+			renderQueue.submitModel(RenderQueue::PASS_SHADOW, modelShadowShader, *Cirno, CirnoModel, false);
+		renderQueue.submitModel(RenderQueue::PASS_SHADOW, modelShadowShader, *tank, tankModel, false);
+		renderQueue.submitModel(RenderQueue::PASS_SHADOW, modelShadowShader, *cannon, cannonModel, false);
 	}
-	else
-		targetInstance.drawByInstance(simpleInstanceObjectShader, cylinder);
-	for (int i = 0; i < targetFrags.size(); i++) {
-		glm::mat4 targetFragModel = MathHelper::getTransformMatrix(
-			targetFrags[i].pos.glmvec3(), targetFrags[i].front.glmvec3(), targetFrags[i].up.glmvec3(),
-			glm::vec3(10, 10, 1));
-		targetFragInstance.addModelMatrix(targetFragModel);
-	}
-	if (tw->drawShadow->value()) {
-		targetFragInstance.drawByInstance(simpleInstanceObjectShader, sector, false);
-		targetFragInstance.setTexture(islandHeightTexture);
-		targetFragInstance.drawByInstance(instanceShadowShader, sector);
+
+	//the floor
+	InstanceDrawer floorInstance(RenderDatabase::GREEN_PLASTIC_MATERIAL);
+	if (!USE_MODEL) {
+		floorInstance.addModelMatrix(MathHelper::getTransformMatrix(glm::vec3(0, -0.5, 0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0), glm::vec3(200, 1, 200)));
+		floorInstance.submit(renderQueue, RenderQueue::PASS_OPAQUE, simpleInstanceObjectShader, cube);
+	}
+
+	//the tree
+	//drawTree(glm::vec3(0, 0, 0));
+
+	// the water and the static models are the most expensive to light, with the pre-pass they are only lit where they are seen
+	bool usePrepass = tw->depthPrepass->value();
+
+	//the water
+	glm::vec3 waterPosition(0, -120, 0);
+	renderQueue.submitCustom(RenderQueue::PASS_OPAQUE, waterShader->variant(), waterPosition, [this, waterPosition]() {
+		drawWater(waterPosition, glm::vec3(2500, 1, 2500));
+	}, usePrepass);
+	if (usePrepass) {
+		renderQueue.submitCustom(RenderQueue::PASS_DEPTH, waterDepthShader, waterPosition, [this, waterPosition]() {
+			drawWater(waterPosition, glm::vec3(2500, 1, 2500), 0.0f, true);
+		});
+	}
+
+	//the models
+	if (USE_MODEL) {
+		// the meshes set their samplers on the bound program, so they are given the variant
+		Shader* litModelShader = modelShader->variant();
+		float modelGamma = log2(tw->gamma->value() * 10) / 4.32193;
+		litModelShader->setFloat("gamma", modelGamma);
+
+		//island, pillar, pillar sections and arrows
+		for (const auto& model : staticModels) {
+			if (viewFrustum.isVisible(model.first->bounds.transform(model.second))) {
+				renderQueue.submitModel(RenderQueue::PASS_OPAQUE, litModelShader, *model.first, model.second, true, usePrepass);
+				if (usePrepass)
+					renderQueue.submitModel(RenderQueue::PASS_DEPTH, depthShader, *model.first, model.second);
+			}
+		}
+
+		//FUMO(fumo)(9), brighter than the others
+		if (drawCirno) {
+			renderQueue.submitCustom(RenderQueue::PASS_OPAQUE, litModelShader, glm::vec3(CirnoModel[3]), [this, litModelShader, modelGamma, CirnoModel]() {
+				litModelShader->setFloat("gamma", modelGamma + 1.12);
+				litModelShader->setMat4("model", CirnoModel);
+				Cirno->Draw(litModelShader);
+				litModelShader->setFloat("gamma", modelGamma);
+			});
+		}
+
+		//tank and cannon
+		renderQueue.submitModel(RenderQueue::PASS_OPAQUE, litModelShader, *tank, tankModel);
+		renderQueue.submitModel(RenderQueue::PASS_OPAQUE, litModelShader, *cannon, cannonModel);
 	}
-	else
-		targetFragInstance.drawByInstance(simpleInstanceObjectShader, sector);
+
+	//the track, sleeper, train
+	if (USE_MODEL)
+		pierInstance.setTexture(islandHeightTexture);
+	pierInstance.submit(renderQueue, RenderQueue::PASS_OPAQUE, pierShader, hollowCube);
+	// rails are evaluated by the tessellation shaders, or drawn from the static mesh
+	if (tw->gpuRail->value()) {
+		glm::vec2 viewportSize(sceneWidth, sceneHeight);
+		renderQueue.submitCustom(RenderQueue::PASS_OPAQUE, railSplineShader->variant(), eyepos, [this, viewportSize]() {
+			splineRail.draw(railSplineShader, RenderDatabase::SLIVER_MATERIAL, viewportSize);
+		});
+	}
+	else {
+		renderQueue.submitCustom(RenderQueue::PASS_OPAQUE, simpleInstanceObjectShader->variant(), eyepos, [this]() {
+			railMesh.draw(simpleInstanceObjectShader, RenderDatabase::SLIVER_MATERIAL, trackChunkVisible);
+		});
+	}
+	sleeperInstance.submit(renderQueue, RenderQueue::PASS_OPAQUE, simpleInstanceObjectShader, cube);
+	trainInstance.submit(renderQueue, RenderQueue::PASS_OPAQUE, simpleInstanceObjectShader, cube);
+	drillInstance.submit(renderQueue, RenderQueue::PASS_OPAQUE, simpleInstanceObjectShader, cone);
+
+	//rockets and targets
+	rocketHeadInstance.submit(renderQueue, RenderQueue::PASS_OPAQUE, simpleInstanceObjectShader, cone);
+	rocketBodyInstance.submit(renderQueue, RenderQueue::PASS_OPAQUE, simpleInstanceObjectShader, cylinder);
+	targetInstance.submit(renderQueue, RenderQueue::PASS_OPAQUE, simpleInstanceObjectShader, cylinder);
+	targetFragInstance.submit(renderQueue, RenderQueue::PASS_OPAQUE, simpleInstanceObjectShader, sector);
+
+	// the shadow map, every caster is drawn once into all of the cascades
+	GLStats::beginPass("shadow");
+	shadowMap.render([&]() {
+		renderQueue.flush(RenderQueue::PASS_SHADOW_STATIC);
+	}, [&]() {
+		renderQueue.flush(RenderQueue::PASS_SHADOW);
+	});
+	GLStats::beginPass("scene");
+
+	// the depth of the pre-passed items, then the opaque pass, front to back in every state
+	if (usePrepass) {
+		GLStats::beginPass("depth");
+		renderQueue.flush(RenderQueue::PASS_DEPTH);
+		GLStats::beginPass("scene");
+	}
+	renderQueue.flush(RenderQueue::PASS_OPAQUE);
+
+	// the whole scene is in the depth buffer now, the occlusion queries are drawn against it
+	// a box encloses its own geometry, so that never hides it
+	if (useOcclusion)
+		occlusionCuller.flush(eyepos);
 
 	//draw axis
 	if (!USE_MODEL) {
+		glUseProgram(0);
 		glLineWidth(5);
 		glBegin(GL_LINES);
 		if (!doingShadows) {
@@ -2683,6 +2762,7 @@ doPick()
 	glPushName(0);
 
 	// draw the cubes, loading the names as we go
+	glUseProgram(0);
 	for (size_t i = 0; i < m_pTrack->points.size(); ++i) {
 		glLoadName((GLuint)(i + 1));
 		m_pTrack->points[i].draw();
@@ -2704,28 +2784,20 @@ doPick()
 }
 
 Pnt3f TrainView::randUnitVector() {
-	int range = 100;
-	int a = -range + (rand() % (2 * range));
-	int b = -range + (rand() % (2 * range));
-	int c = -range + (rand() % (2 * range));
-	Pnt3f v(a / 100.0f, b / 100.0f, c / 100.0f);
-	v.normalize();
-	return v;
+	return Pnt3f(Random::local().nextUnitVector());
 }
 
 void TrainView::addTarget()
 {
 	using namespace std;
-	int rangeX = (140) - (-260);
-	int rangeY = 100;
-	int rangeZ = (350) - (-70);
-	int x = -260 + (rand() % rangeX);
-	int y = 5 + rand() % (rangeY);
-	int z = -70 + (rand() % rangeZ);
+	Random& random = Random::local();
+	int x = random.nextInt(-260, 140);
+	int y = random.nextInt(5, 105);
+	int z = random.nextInt(-70, 350);
 
 	Pnt3f front = randUnitVector();
 	front.normalize();
-	targets.push_back(Entity(Pnt3f(x, y, z), front, front * Pnt3f(1, 0, 0)));
+	targets.add(Pnt3f(x, y, z), front, front * Pnt3f(1, 0, 0));
 }
 
 void TrainView::addMoreTarget()
@@ -2741,11 +2813,22 @@ void TrainView::shoot()
 	lastShootTime = tw->clock_time;
 	lookingFront.normalize();
 	lookingUp.normalize();
-	Rocket rocket(trainPos + lookingFront * 10, lookingFront, lookingUp);
+	Pnt3f launchPos = trainPos + lookingFront * 10;
 	if (USE_MODEL)
-		rocket = Rocket(trainPos + trainFront * 4 + trainUp * 5 + lookingFront * 15, lookingFront, lookingUp);
-	rocket.thrusterVelocity = lookingFront * 4;
-	rockets.push_back(rocket);
+		launchPos = trainPos + trainFront * 4 + trainUp * 5 + lookingFront * 15;
+	EntityHandle rocket = rockets.add(launchPos, lookingFront, lookingUp);
+	rockets.velocity[rockets.indexOf(rocket)] = lookingFront * 4;	// thruster
+
+	// give it the generator of a removed rocket, or a new one
+	size_t smoke = 0;
+	while (smoke < smokeRocket.size() && rockets.indexOf(smokeRocket[smoke]) != -1)
+		smoke++;
+	if (smoke == smokeRocket.size()) {
+		smokeGenerator.push_back(particleSystem.addParticleGenerator_pointer(particleShader));
+		smokeRocket.push_back(rocket);
+	}
+	else
+		smokeRocket[smoke] = rocket;
 
 	soundSource_RPGshot->Play(RPGshot);
 
@@ -2757,130 +2840,128 @@ void TrainView::shoot()
 // judge the sleeperDistance of target and rocket
 void TrainView::collisionJudge()
 {
-	for (int targetID = 0; targetID < targets.size(); targetID++) {
-		for (int rocketID = 0; rocketID < rockets.size(); rocketID++) {
-			if (targets[targetID].state == 0 && rockets[rocketID].state == 0) {
-				if (MathHelper::segmentIntersectCircle(
-					rockets[rocketID].pos, rockets[rocketID].lastPos,
-					targets[targetID].pos, targets[targetID].front, 5)) {
-
-					targets[targetID].state = 1;
-					rockets[rocketID].state = 1;
-
-					lastExplodeTime = tw->clock_time;
-					lastExplodePos = targets[targetID].pos;
-
-					//target explode paricle effect
-					//smoke
-					ParticleGenerator& g1 = particleSystem.addParticleGenerator(particleShader);
-					g1.setPosition(targets[targetID].pos.glmvec3());
-					g1.setLife(2);
-					g1.setColor(glm::vec3(0.078f, 0.078f, 0.078f), glm::vec3(0.273f, 0.273f, 0.273f), glm::vec3(0.273f, 0.273f, 0.273f), 0.7);
-					g1.setParticleVelocity(3);
-					g1.setParticleVelocityRandomOffset(1);
-					g1.setFriction(0.85);
-					g1.setParticleLife(65);
-					g1.setParticleLifeRandomOffset(15);
-					g1.setGenerateRate(80);
-					g1.setGravity(-0.07);
-					g1.setParticleSize(0.5);
-					//outer fire
-					ParticleGenerator& g2 = particleSystem.addParticleGenerator(particleShader);
-					g2.setPosition(targets[targetID].pos.glmvec3());
-					g2.setLife(2);
-					g2.setColor(glm::vec3(0.98f, 0.99f, 0.039f), glm::vec3(0.98f, 0.99f, 0.039f), glm::vec3(0.98f, 0.99f, 0.039f), 0.5);
-					g2.setParticleVelocity(7);
-					g2.setParticleVelocityRandomOffset(2);
-					g2.setFriction(0.95);
-					g2.setParticleLife(100);
-					g2.setGenerateRate(80);
-					g2.setGravity(0.15);
-					g2.setParticleSize(0.3);
-					//inner fire
-					ParticleGenerator& g3 = particleSystem.addParticleGenerator(particleShader);
-					g3.setPosition(targets[targetID].pos.glmvec3());
-					g3.setLife(2);
-					g3.setColor(glm::vec3(1.0f, 0.105f, 0.039f), glm::vec3(1.0f, 0.621f, 0.0195f), glm::vec3(1.0f, 0.914f, 0.0195f), 0.7);
-					g3.setParticleVelocity(3);
-					g3.setParticleVelocityRandomOffset(1);
-					g3.setFriction(0.85);
-					g3.setParticleLife(40);
-					g3.setParticleLifeRandomOffset(10);
-					g3.setGenerateRate(80);
-					g3.setGravity(0);
-					g3.setParticleSize(0.7);
-
-					soundSource_targetExplosion->Play(targetExplosion);
-				}
-			}
-		}
-	}
+	rockets.findHits(targets, targetHash, [&](int rocketID, int targetID) {
+		targets.state[targetID] = 1;
+		rockets.state[rocketID] = 1;
+
+		lastExplodeTime = tw->clock_time;
+		lastExplodePos = targets.pos[targetID];
+		lightClusters.addFlash(targets.pos[targetID].glmvec3(), EXPLOSION_LIGHT_COLOR, EXPLOSION_LIGHT_RADIUS, EXPLOSION_LIGHT_LIFE);
+
+		ALLOC_SCOPE(ALLOC_PARTICLES);
+		//target explode paricle effect
+		//smoke
+		ParticleGenerator& g1 = particleSystem.addParticleGenerator(particleShader);
+		g1.setPosition(targets.pos[targetID].glmvec3());
+		g1.setLife(2);
+		g1.setColor(glm::vec3(0.078f, 0.078f, 0.078f), glm::vec3(0.273f, 0.273f, 0.273f), glm::vec3(0.273f, 0.273f, 0.273f), 0.7);
+		g1.setParticleVelocity(3);
+		g1.setParticleVelocityRandomOffset(1);
+		g1.setFriction(0.85);
+		g1.setParticleLife(65);
+		g1.setParticleLifeRandomOffset(15);
+		g1.setGenerateRate(80);
+		g1.setGravity(-0.07);
+		g1.setParticleSize(0.5);
+		//outer fire
+		ParticleGenerator& g2 = particleSystem.addParticleGenerator(particleShader);
+		g2.setPosition(targets.pos[targetID].glmvec3());
+		g2.setLife(2);
+		g2.setColor(glm::vec3(0.98f, 0.99f, 0.039f), glm::vec3(0.98f, 0.99f, 0.039f), glm::vec3(0.98f, 0.99f, 0.039f), 0.5);
+		g2.setParticleVelocity(7);
+		g2.setParticleVelocityRandomOffset(2);
+		g2.setFriction(0.95);
+		g2.setParticleLife(100);
+		g2.setGenerateRate(80);
+		g2.setGravity(0.15);
+		g2.setParticleSize(0.3);
+		//inner fire
+		ParticleGenerator& g3 = particleSystem.addParticleGenerator(particleShader);
+		g3.setPosition(targets.pos[targetID].glmvec3());
+		g3.setLife(2);
+		g3.setColor(glm::vec3(1.0f, 0.105f, 0.039f), glm::vec3(1.0f, 0.621f, 0.0195f), glm::vec3(1.0f, 0.914f, 0.0195f), 0.7);
+		g3.setParticleVelocity(3);
+		g3.setParticleVelocityRandomOffset(1);
+		g3.setFriction(0.85);
+		g3.setParticleLife(40);
+		g3.setParticleLifeRandomOffset(10);
+		g3.setGenerateRate(80);
+		g3.setGravity(0);
+		g3.setParticleSize(0.7);
+
+		soundSource_targetExplosion->Play(targetExplosion);
+	});
 }
 
 void TrainView::updateEntity() {
+	ALLOC_SCOPE(ALLOC_ENTITIES);
 	if (tw->runButton->value()) {
-		for (int rocketID = 0; rocketID < rockets.size(); rocketID++) {
-			if (rockets[rocketID].state > 1 || rockets[rocketID].pos.len2() > 1000000 || rockets[rocketID].pos.y < -150) {
-				rockets.erase(rockets.begin() + rocketID);
-				rocketID--;
-				continue;
-			}
-			else if (rockets[rocketID].state > 0) {
-				// TODO: EXPLOSION!
-				rockets[rocketID].state++;
-			}
-			else {
-				// move it
-				rockets[rocketID].advance();
+		// every rocket and fragment moves by itself, integrate them on all threads
+		// and remove the dead ones after the join
+		ArenaVector<char> rocketDead(rockets.size());
+		JobSystem::get().parallelFor(0, rockets.size(), ENTITY_JOB_GRAIN, [&](int first, int last) {
+			for (int rocketID = first; rocketID < last; rocketID++) {
+				if (rockets.state[rocketID] > 1 || rockets.pos[rocketID].len2() > 1000000 || rockets.pos[rocketID].y < -150) {
+					rocketDead[rocketID] = true;
+				}
+				else if (rockets.state[rocketID] > 0) {
+					// TODO: EXPLOSION!
+					rockets.state[rocketID]++;
+				}
+				else {
+					// move it
+					rockets.advance(rocketID);
+				}
 			}
+			rockets.updateMatrices(first, last);
+		});
+		// swap-remove from the back, the entity moved into a hole is checked already
+		for (int rocketID = rockets.size() - 1; rocketID >= 0; rocketID--) {
+			if (rocketDead[rocketID])
+				rockets.remove(rocketID);
 		}
 
-		for (int targetID = 0; targetID < targets.size(); targetID++) {
-			if (targets[targetID].state > 0) {
+		for (int targetID = targets.size() - 1; targetID >= 0; targetID--) {
+			if (targets.state[targetID] > 0) {
 				// add its fragments
 				for (int i = 0; i < 3; i++) {
 					Pnt3f front = randUnitVector();
-					PhysicalEntity frag(targets[targetID].pos + 2.5 * randUnitVector(), front, front * randUnitVector());
-					frag.velocity = (frag.pos - targets[targetID].pos) * (0.5 + (rand() % 30) / 10.0);
-					frag.angularVelocity = randUnitVector() * (rand() % 10);
-					targetFrags.push_back(frag);
+					int fragID = targetFrags.size();
+					targetFrags.add(targets.pos[targetID] + 2.5 * randUnitVector(), front, front * randUnitVector());
+					targetFrags.velocity[fragID] = (targetFrags.pos[fragID] - targets.pos[targetID]) * (0.5 + Random::local().nextInt(0, 30) / 10.0);
+					targetFrags.angularVelocity[fragID] = randUnitVector() * Random::local().nextInt(0, 10);
 				}
 				// delete this
-				targets.erase(targets.begin() + targetID);
-				targetID--;
-				continue;
+				targets.remove(targetID);
 			}
 		}
-		for (int fragID = 0; fragID < targetFrags.size(); fragID++) {
-			if (targetFrags[fragID].state < 1000 && targetFrags[fragID].pos.y>-5) {
-				targetFrags[fragID].advance();
-				targetFrags[fragID].state++;
-			}
-			else {
-				// delete
-				targetFrags.erase(targetFrags.begin() + fragID);
-				fragID--;
-				continue;
+		ArenaVector<char> fragDead(targetFrags.size());
+		JobSystem::get().parallelFor(0, targetFrags.size(), ENTITY_JOB_GRAIN, [&](int first, int last) {
+			for (int fragID = first; fragID < last; fragID++) {
+				if (targetFrags.state[fragID] < 1000 && targetFrags.pos[fragID].y > -5) {
+					targetFrags.advance(fragID);
+					targetFrags.state[fragID]++;
+				}
+				else {
+					fragDead[fragID] = true;
+				}
 			}
+			targetFrags.updateMatrices(first, last);
+		});
+		for (int fragID = targetFrags.size() - 1; fragID >= 0; fragID--) {
+			if (fragDead[fragID])
+				targetFrags.remove(fragID);
 		}
 	}
 }
 
-void TrainView::gigaDrillBreak()
+// the train and drills of the animation are added to the drawers of drawStuff()
+void TrainView::gigaDrillBreak(InstanceDrawer& trainInstance, InstanceDrawer& drillInstance)
 {
 	using namespace MathHelper;
 
 
-	Material trainMaterial = {
-		glm::vec3(0.89225f, 0.19225f, 0.19225f),
-		glm::vec3(0.80754f, 0.50754f, 0.50754f),
-		glm::vec3(0.808273f, 0.508273f, 0.508273f),
-		128.0f
-	};
-	InstanceDrawer trainInstance(trainMaterial);
-	InstanceDrawer drillInstance(RenderDatabase::SLIVER_MATERIAL);
 	InstanceDrawer blackLineInstance(RenderDatabase::SLIVER_MATERIAL);
-	drillInstance.setTexture(this->getObjectTexture("drillImage"));
 
 	static Pnt3f originalFront;
 	static Pnt3f originalUp;
@@ -3051,7 +3132,7 @@ void TrainView::gigaDrillBreak()
 		}
 
 		if (animationFrame >= 330 && !exploded) {
-			targetChainExplosionStart(Entity(Pnt3f(0, 0, 0), Pnt3f(0, 0, -1), Pnt3f(0, 1, 0)));
+			targetChainExplosionStart(Pnt3f(0, 0, 0));
 			exploded = true;
 		}
 	}
@@ -3059,45 +3140,20 @@ void TrainView::gigaDrillBreak()
 		animationFrame = 0;
 	}
 
-	if (tw->drawShadow->value() && animationFrame < keyFrame[10]) {
-		if (!USE_MODEL) {
-			trainInstance.drawByInstance(simpleInstanceObjectShader, cube, false);
-			trainInstance.setTexture(islandHeightTexture);
-			trainInstance.drawByInstance(instanceShadowShader, cube);
-		}
-		drillInstance.drawByInstance(simpleInstanceObjectShader, cone, false);
-		drillInstance.setTexture(islandHeightTexture);
-		drillInstance.drawByInstance(instanceShadowShader, cone);
-	}
-	else {
-		drillInstance.drawByInstance(simpleInstanceObjectShader, cone);
-		if (!USE_MODEL) {
-			trainInstance.drawByInstance(simpleInstanceObjectShader, cube);
-		}
-	}
 	blackLineInstance.drawByInstance(drillShader, cone);
-	glUseProgram(0);
 }
 
 //call by trainWindow every clock
 void TrainView::updateParticleSystem() {
+	ALLOC_SCOPE(ALLOC_PARTICLES);
 	particleSystem.update();
 }
 
-void TrainView::targetChainExplosionStart(Entity startTarget) {
+void TrainView::targetChainExplosionStart(Pnt3f center) {
 	if (targetChainExplosionStartTime != INFINITY) return;
 
-	//sort tartget pos
-	for (int i = 0; i < targets.size(); i++) {
-		for (int j = 0; j < targets.size() - 1 - i; j++) {
-			if (MathHelper::distance(startTarget.pos, targets[j].pos) > MathHelper::distance(startTarget.pos, targets[j + 1].pos)) {
-				//swap
-				Entity temp = targets[j];
-				targets[j] = targets[j + 1];
-				targets[j + 1] = temp;
-			}
-		}
-	}
+	//the targets explode from the nearest to the center
+	targetChainExplosionCenter = center;
 
 	targetChainExplosionStartTime = tw->clock_time;
 	targetChainExplosionFrameCount = 0;
@@ -3116,12 +3172,16 @@ void TrainView::targetChainExplosionUpdate() {
 	targetChainExplosionFrameCount -= 1;
 
 	int explosionNum = (int)(animationTime / 30.0f) + 1;
-	for (int targetID = 0; targetID < explosionNum && targetID < targets.size(); targetID++) {
-		targets[targetID].state = 1;
+	// the hash is built by collisionJudge() of this frame
+	ArenaVector<int> nearTargets;
+	targetHash.nearest(targetChainExplosionCenter, explosionNum, [this](int targetID) { return targets.state[targetID] == 0; }, nearTargets);
+	for (int targetID : nearTargets) {
+		targets.state[targetID] = 1;
+		ALLOC_SCOPE(ALLOC_PARTICLES);
 		//target explode paricle effect
 		//smoke
 		ParticleGenerator& g1 = particleSystem.addParticleGenerator(particleShader);
-		g1.setPosition(targets[targetID].pos.glmvec3());
+		g1.setPosition(targets.pos[targetID].glmvec3());
 		g1.setLife(2);
 		g1.setColor(glm::vec3(1.0f, 0.105f, 0.039f), glm::vec3(0.078f, 0.078f, 0.078f), glm::vec3(0.078f, 0.078f, 0.078f), 0.7);
 		g1.setParticleVelocity(3);
@@ -3134,7 +3194,7 @@ void TrainView::targetChainExplosionUpdate() {
 		g1.setParticleSize(0.5);
 		//outer fire
 		ParticleGenerator& g2 = particleSystem.addParticleGenerator(particleShader);
-		g2.setPosition(targets[targetID].pos.glmvec3());
+		g2.setPosition(targets.pos[targetID].glmvec3());
 		g2.setLife(2);
 		g2.setColor(glm::vec3(0.98f, 0.99f, 0.039f), glm::vec3(0.98f, 0.99f, 0.039f), glm::vec3(0.98f, 0.99f, 0.039f), 0.5);
 		g2.setParticleVelocity(20);
@@ -3145,7 +3205,7 @@ void TrainView::targetChainExplosionUpdate() {
 		g2.setParticleSize(0.3);
 		//inner fire
 		ParticleGenerator& g3 = particleSystem.addParticleGenerator(particleShader);
-		g3.setPosition(targets[targetID].pos.glmvec3());
+		g3.setPosition(targets.pos[targetID].glmvec3());
 		g3.setLife(2);
 		g3.setColor(glm::vec3(1.0f, 0.105f, 0.039f), glm::vec3(1.0f, 0.621f, 0.0195f), glm::vec3(1.0f, 0.914f, 0.0195f), 0.7);
 		g3.setParticleVelocity(3);
@@ -3156,6 +3216,7 @@ void TrainView::targetChainExplosionUpdate() {
 		g3.setGenerateRate(80);
 		g3.setGravity(0);
 		g3.setParticleSize(1.2);
+		lightClusters.addFlash(targets.pos[targetID].glmvec3(), EXPLOSION_LIGHT_COLOR, EXPLOSION_LIGHT_RADIUS, EXPLOSION_LIGHT_LIFE);
 
 		lastExplodeTime = tw->clock_time;
 	}
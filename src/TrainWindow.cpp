@@ -34,6 +34,7 @@
 #include "TrainWindow.H"
 #include "TrainView.H"
 #include "CallBacks.H"
+#include "InputRecorder.h"
 
 
 
@@ -88,33 +89,33 @@ TrainWindow(const int x, const int y)
         worldCam->type(FL_RADIO_BUTTON);		// radio button
         worldCam->value(1);			// turned on
         worldCam->selection_color((Fl_Color)3); // yellow when pressed
-		worldCam->callback((Fl_Callback*)damageCB,this);
+		worldCam->callback((Fl_Callback*)cameraCB,this);
 		trainCam = new Fl_Button(670, pty, 60, 20, "Tank");
         trainCam->type(FL_RADIO_BUTTON);
         trainCam->value(0);
         trainCam->selection_color((Fl_Color)3);
-		trainCam->callback((Fl_Callback*)damageCB,this);
+		trainCam->callback((Fl_Callback*)cameraCB,this);
 		topCam = new Fl_Button(735, pty, 60, 20, "Top");
         topCam->type(FL_RADIO_BUTTON);
         topCam->value(0);
         topCam->selection_color((Fl_Color)3);
-		topCam->callback((Fl_Callback*)damageCB,this);
+		topCam->callback((Fl_Callback*)cameraCB,this);
 		pty += 25;
 		freeCam = new Fl_Button(605, pty, 60, 20, "Free");
 		freeCam->type(FL_RADIO_BUTTON);
 		freeCam->value(0);
 		freeCam->selection_color((Fl_Color)3);
-		freeCam->callback((Fl_Callback*)damageCB, this);
+		freeCam->callback((Fl_Callback*)cameraCB, this);
 		CirnoCam = new Fl_Button(670, pty, 60, 20, "Cirno");
 		CirnoCam->type(FL_RADIO_BUTTON);
 		CirnoCam->value(0);
 		CirnoCam->selection_color((Fl_Color)3);
-		CirnoCam->callback((Fl_Callback*)damageCB, this);
+		CirnoCam->callback((Fl_Callback*)cameraCB, this);
 		CirnoerCam = new Fl_Button(735, pty, 60, 20, "Cirnoer");
 		CirnoerCam->type(FL_RADIO_BUTTON);
 		CirnoerCam->value(0);
 		CirnoerCam->selection_color((Fl_Color)3);
-		CirnoerCam->callback((Fl_Callback*)damageCB, this);
+		CirnoerCam->callback((Fl_Callback*)cameraCB, this);
 		camGroup->end();
 
 		pty += 30;
@@ -173,6 +174,16 @@ TrainWindow(const int x, const int y)
 		gamma->align(FL_ALIGN_LEFT);
 		gamma->type(FL_HORIZONTAL);
 
+		pty += 25;
+
+		// the most a piece of track can be away from the curve
+		trackTolerance = new Fl_Value_Slider(655, pty, 140, 20, "tolerance");
+		trackTolerance->range(0.01, 1);
+		trackTolerance->value(TrackTessellator::DEFAULT_TOLERANCE);
+		trackTolerance->precision(2);
+		trackTolerance->align(FL_ALIGN_LEFT);
+		trackTolerance->type(FL_HORIZONTAL);
+
 		pty += 30;
 
 		drawShadow = new Fl_Button(605, pty, 60, 20, "Shadow");
@@ -181,6 +192,27 @@ TrainWindow(const int x, const int y)
 		showControlPoint = new Fl_Button(670, pty, 60, 20, "Points");
 		togglify(showControlPoint);
 		showControlPoint->set();
+		occlusionCull = new Fl_Button(735, pty, 60, 20, "Occlude");
+		togglify(occlusionCull);
+		occlusionCull->callback((Fl_Callback*)occlusionCB, this);
+
+		pty += 25;
+
+		// evaluate the rails by tessellation shaders
+		gpuRail = new Fl_Button(605, pty, 60, 20, "GPU Rail");
+		togglify(gpuRail);
+		// GL call counts over the view and in gl_stats.csv
+		glStats = new Fl_Button(670, pty, 60, 20, "GL Stats");
+		togglify(glStats);
+		// the depth of the models and water first, they are lit only where they are seen
+		depthPrepass = new Fl_Button(735, pty, 60, 20, "Prepass");
+		togglify(depthPrepass);
+
+		pty += 25;
+
+		// the scene is drawn smaller to hold the frame time
+		dynamicResolution = new Fl_Button(605, pty, 60, 20, "Dyn Res");
+		togglify(dynamicResolution);
 
 		pty += 30;
 
@@ -224,6 +256,23 @@ cycle_time()
 
 }
 
+int TrainWindow::
+cameraIndex()
+{
+	Fl_Button* cameras[CAMERA_AMOUNT] = { worldCam, trainCam, topCam, freeCam, CirnoCam, CirnoerCam };
+	for (int i = 0; i < CAMERA_AMOUNT; i++) {
+		if (cameras[i]->value())
+			return i;
+	}
+	return 0;
+}
+
+bool TrainWindow::
+useOcclusion()
+{
+	return occlusionPerCamera[cameraIndex()];
+}
+
 //************************************************************************
 //
 // *
@@ -249,6 +298,7 @@ advanceTrain(float dir)
 	//#####################################################################
 	// TODO: make this work for your train
 	//#####################################################################
+	InputRecorder::get().onTick();
 	static clock_t lastAnimationUpdate = clock();
 	if (trainView->animationFrame == 0) {	// it won't move when playing animation
 		static float gradientSpeed = 1;
@@ -267,7 +317,8 @@ advanceTrain(float dir)
 	}
 	else {
 		double elapsed = static_cast<double>(clock() - lastAnimationUpdate) / CLOCKS_PER_SEC;
-		if (elapsed > 0.3)
+		// a fixed time step, so a recording plays the same animation
+		if (elapsed > 0.3 || InputRecorder::get().getMode() != InputRecorder::OFF)
 			elapsed = 1.0 / 30.0;
 		trainView->animationFrame += elapsed*30.0*RenderDatabase::timeScale*dir;	// update animation
 	}
@@ -23,7 +23,10 @@
 *************************************************************************/
 
 #include "stdio.h"
+#include <string.h>
 #include "TrainWindow.H"
+#include "InputRecorder.h"
+#include "FrameCapture.h"
 
 #pragma warning(push)
 #pragma warning(disable:4312)
@@ -32,11 +35,20 @@
 #pragma warning(pop)
 
 
-int main(int, char**)
+int main(int argc, char** argv)
 {
 	printf("CS559 Train Assignment\n");
 
 	TrainWindow tw;
+	// --record <file> or --replay <file>, --capture <directory or .y4m file>
+	for (int i = 1; i + 1 < argc; i++) {
+		if (strcmp(argv[i], "--record") == 0)
+			InputRecorder::get().startRecording(argv[++i], &tw);
+		else if (strcmp(argv[i], "--replay") == 0)
+			InputRecorder::get().startReplay(argv[++i], &tw);
+		else if (strcmp(argv[i], "--capture") == 0)
+			FrameCapture::get().start(argv[++i]);
+	}
 	tw.show();
 	tw.damageMe();
 	Fl::run();